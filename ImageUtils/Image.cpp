@@ -1,6 +1,10 @@
+#include <algorithm>
 #include <fstream>
+#include <iterator>
+#include <stdexcept>
 #include "Image.hpp"
 #include "PixelConverter.hpp"
+#include "../encodingUtils/ThreadPool.hpp"
 
 using namespace std;
 /**
@@ -25,13 +29,35 @@ Image::Image(const Matrix<YCbCrPixel, Dynamic, Dynamic>& image) {
     encodeInit();
 }
 
+/**
+ * Create an empty ImageUtils, to be filled by read()
+ */
+Image::Image(): width{0}, height{0} {
+}
+
 /**
  * Create an ImageUtils from a file
  * @param filename The filename to read
  */
 Image::Image(const std::string& filename) {
     ifstream imageFile(filename);
+    read(imageFile);
+}
 
+/**
+ * Create an ImageUtils from the contents of a file, e.g. a file already read to memory
+ * @param stream The stream to read, positioned at the start of the file
+ */
+Image::Image(std::istream& stream) {
+    read(stream);
+}
+
+/**
+ * Replace the contents with an image read from a stream. The pixel storage is reused when the size does not change.
+ * @param imageFile The stream to read, positioned at the start of the file
+ * @throw runtime_error if the stream ends before every pixel was read
+ */
+void Image::read(std::istream& imageFile) {
     string line;
     getline(imageFile, line); // P3 or P6
     getline(imageFile, line); // comment
@@ -40,7 +66,6 @@ Image::Image(const std::string& filename) {
     width = stoi(line.substr(0, 3));
     height = stoi(line.substr(4, 6));
 
-    rgbImage = *(new Matrix<RGBPixel, Dynamic, Dynamic>());
     rgbImage.resize(height, width);
 
     getline(imageFile, line);
@@ -62,10 +87,15 @@ Image::Image(const std::string& filename) {
         rgbImage(i / width, i % width) = pixel;
         i++;
     }
+    if(i != width * height) {
+        // a recycled image would keep the pixels of the previous one
+        throw runtime_error("image holds " + to_string(i) + " of " + to_string(width * height) + " pixels");
+    }
 
     rgbLoaded = true;
-    imageFile.close();
+    yCbCrLoaded = false;
 
+    blockLocations.clear();
     encodeInit();
 }
 
@@ -151,19 +181,53 @@ int Image::getHeight() const {
 
 std::tuple<std::vector<Block>, std::vector<Block>, std::vector<Block>> Image::encode() {
     getYCbCrImage();
-    auto yBlocks = encodeYComponent();
-    auto uBlocks = encodeUComponent();
-    auto vBlocks = encodeVComponent();
+    auto yBlocks = encodeYComponent(0, blockLocations.size());
+    auto uBlocks = encodeUComponent(0, blockLocations.size());
+    auto vBlocks = encodeVComponent(0, blockLocations.size());
 
     return make_tuple(yBlocks, uBlocks, vBlocks);
 }
 
-vector<Block> Image::encodeYComponent() {
+/**
+ * Extract the blocks of every block row on a separate task of the pool
+ * @param pool The threads to use
+ * @return The same blocks as encode()
+ */
+std::tuple<std::vector<Block>, std::vector<Block>, std::vector<Block>> Image::encode(ThreadPool& pool) {
+    // convert once, the tasks only read the converted image
+    getYCbCrImage();
+
+    size_t blocksPerRow = getWidth() / 8;
+    size_t blockRows = blockLocations.size() / blocksPerRow;
+    vector<tuple<vector<Block>, vector<Block>, vector<Block>>> rows(blockRows);
+
+    pool.parallelFor(blockRows, [&](size_t r) {
+        size_t first = r * blocksPerRow, last = first + blocksPerRow;
+        rows[r] = make_tuple(encodeYComponent(first, last), encodeUComponent(first, last),
+                             encodeVComponent(first, last));
+    });
+
+    // join the rows in order
+    vector<Block> yBlocks, uBlocks, vBlocks;
+    yBlocks.reserve(blockLocations.size());
+    uBlocks.reserve(blockLocations.size());
+    vBlocks.reserve(blockLocations.size());
+    for(auto& row : rows) {
+        move(get<0>(row).begin(), get<0>(row).end(), back_inserter(yBlocks));
+        move(get<1>(row).begin(), get<1>(row).end(), back_inserter(uBlocks));
+        move(get<2>(row).begin(), get<2>(row).end(), back_inserter(vBlocks));
+    }
+
+    return make_tuple(move(yBlocks), move(uBlocks), move(vBlocks));
+}
+
+vector<Block> Image::encodeYComponent(size_t first, size_t last) {
     vector<Block> blocks;
     Matrix<int, Dynamic, Dynamic> tmpVals;
     tmpVals.resize(8,8);
 
-    for(const tuple<pair<int, int>, pair<int, int>, pair<int, int>, pair<int, int>>& corners : blockLocations){
+    for(size_t b=first; b<last; b++){
+        const auto& corners = blockLocations[b];
         int row=0, col=0;
         // load all Y values in the tmpVals vector, create a block with this vector and add it to the blocks vector
         for(int i=get<0>(corners).first; i < get<2>(corners).first; i++) {
@@ -181,13 +245,14 @@ vector<Block> Image::encodeYComponent() {
     return blocks;
 }
 
-std::vector<Block> Image::encodeUComponent() {
+std::vector<Block> Image::encodeUComponent(size_t first, size_t last) {
     vector<Block> blocks;
     Matrix<int, Dynamic, Dynamic> tmpVals;
     tmpVals.resize(4,4);
 
     // corners: corner coords of a block
-    for(const tuple<pair<int, int>, pair<int, int>, pair<int, int>, pair<int, int>>& corners : blockLocations){
+    for(size_t b=first; b<last; b++){
+        const auto& corners = blockLocations[b];
         int row=0, col=0;
 
         // step 2 for i, j.
@@ -210,12 +275,13 @@ std::vector<Block> Image::encodeUComponent() {
     return blocks;
 }
 
-std::vector<Block> Image::encodeVComponent() {
+std::vector<Block> Image::encodeVComponent(size_t first, size_t last) {
     vector<Block> blocks;
     Matrix<int, Dynamic, Dynamic> tmpVals;
     tmpVals.resize(4,4);
 
-    for(const tuple<pair<int, int>, pair<int, int>, pair<int, int>, pair<int, int>>& corners : blockLocations){
+    for(size_t b=first; b<last; b++){
+        const auto& corners = blockLocations[b];
         int row=0, col=0;
         // step 2 for i, j.
         // Take the average in each 2x2 sub-block
@@ -346,6 +412,60 @@ Image Image::decode(tuple<vector<Block*>, vector<Block*>, vector<Block*>> uviBlo
     return Image(imageMatrix);
 }
 
+/**
+ * Reconstruct the image straight to RGB, every block row on a separate task of the pool.
+ * A block row is done in a single pass: each sample is converted as soon as its Y, Cb and Cr values are known, the
+ * YCbCr image is never built.
+ * @param blocks The 8x8 Y blocks and the 4x4 Cb and Cr blocks, in raster order. nullptr blocks, like the ones outside
+ *               the region of TiledFrame::decodeRegion, are left black.
+ * @param rows The height of the image
+ * @param cols The width of the image
+ * @param pool The threads to use
+ * @return The image decode(blocks, rows, cols).getRGBImage() would give
+ */
+Image Image::decode(const tuple<vector<Block*>, vector<Block*>, vector<Block*>>& blocks, int rows, int cols,
+                    ThreadPool& pool) {
+    Matrix<RGBPixel, Dynamic, Dynamic> rgb;
+    rgb.resize(rows, cols);
+
+    const auto& yBlocks = get<0>(blocks);
+    const auto& cbBlocks = get<1>(blocks);
+    const auto& crBlocks = get<2>(blocks);
+    int blocksPerRow = cols / 8;
+
+    pool.parallelFor(static_cast<size_t>(rows / 8), [&](size_t blockRow) {
+        int top = static_cast<int>(blockRow) * 8;
+        for(int blockCol=0; blockCol<blocksPerRow; blockCol++) {
+            size_t idx = blockRow * blocksPerRow + blockCol;
+            const Block* y = yBlocks[idx];
+            const Block* cb = cbBlocks[idx];
+            const Block* cr = crBlocks[idx];
+            int left = blockCol * 8;
+
+            if(not y || not cb || not cr) {
+                for(int j=0; j<8; j++) {
+                    for(int i=0; i<8; i++) {
+                        rgb(top + i, left + j) = RGBPixel{0, 0, 0};
+                    }
+                }
+                continue;
+            }
+
+            // the matrix is column major, walk down the columns
+            for(int j=0; j<8; j++) {
+                for(int i=0; i<8; i++) {
+                    YCbCrPixel pixel{static_cast<unsigned char>(y->values(i, j)),
+                                     static_cast<unsigned char>(cb->values(i / 2, j / 2)),
+                                     static_cast<unsigned char>(cr->values(i / 2, j / 2))};
+                    rgb(top + i, left + j) = PixelConverter::YCbCrToRGB(pixel);
+                }
+            }
+        }
+    });
+
+    return Image(rgb);
+}
+
 RGBPixel Image::operator()(int row, int col) {
     getRGBImage();
     return rgbImage(row, col);
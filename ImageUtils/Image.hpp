@@ -1,5 +1,7 @@
 #pragma once
 
+#include <istream>
+
 #include "../Eigen/Dense"
 #include "RgbPixel.hpp"
 #include "../Eigen/src/Core/util/Constants.h"
@@ -8,17 +10,24 @@
 using Eigen::Matrix;
 using Eigen::Dynamic;
 
+class ThreadPool;
+
 class Image {
 public:
+    Image();
     explicit Image(const std::string& filename);
+    explicit Image(std::istream& stream);
     explicit Image(const Matrix<RGBPixel, Dynamic, Dynamic>& image);
     explicit Image(const Matrix<YCbCrPixel, Dynamic, Dynamic>& image);
 
     Matrix<YCbCrPixel, Dynamic, Dynamic> getYCbCrImage();
     Matrix<RGBPixel, Dynamic, Dynamic> getRGBImage();
     std::tuple<std::vector<Block>, std::vector<Block>, std::vector<Block>> encode();
+    std::tuple<std::vector<Block>, std::vector<Block>, std::vector<Block>> encode(ThreadPool& pool);
 
     static Image decode(std::tuple<std::vector<Block*>, std::vector<Block*>, std::vector<Block*>>, int rows, int cols);
+    static Image decode(const std::tuple<std::vector<Block*>, std::vector<Block*>, std::vector<Block*>>& blocks,
+                        int rows, int cols, ThreadPool& pool);
 
     int getWidth() const;
     int getHeight() const;
@@ -26,13 +35,14 @@ public:
     RGBPixel operator()(int row, int col);
 
     void write(const std::string& file);
+    void read(std::istream& stream);
 
     ~Image();
 private:
     void encodeInit();
-    std::vector<Block> encodeYComponent();
-    std::vector<Block> encodeUComponent();
-    std::vector<Block> encodeVComponent();
+    std::vector<Block> encodeYComponent(size_t first, size_t last);
+    std::vector<Block> encodeUComponent(size_t first, size_t last);
+    std::vector<Block> encodeVComponent(size_t first, size_t last);
 
     std::vector<std::tuple<std::pair<int, int>, std::pair<int, int>, std::pair<int, int>, std::pair<int, int>>> blockLocations;
 
@@ -0,0 +1,166 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include "../encodingUtils/CoefficientDump.hpp"
+#include "../encodingUtils/EntropyCoder.hpp"
+#include "../encodingUtils/EntropyDecoder.hpp"
+
+using namespace std;
+
+/**
+ * Entropy stage benchmark.
+ *
+ * Usage: entropy_benchmark [dump file] [iterations]
+ * The dump file is written to ../blocksOut/coefficients.dump by video_encoder_decoder --dump-coefficients
+ */
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // size of a block of the dump when stored as 16 bit values, used for the MB/s figures
+    const double BLOCK_BYTES = 64 * 2;
+    const char* PLANE_NAMES[3] = {"Y", "Cb", "Cr"};
+
+    double secondsSince(Clock::time_point start) {
+        return chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    void printRate(const string& name, double seconds, size_t symbols, size_t blocks) {
+        cout << left << setw(28) << name << right
+             << setw(10) << fixed << setprecision(2) << symbols / seconds / 1e6 << " Msymbols/s"
+             << setw(10) << blocks * BLOCK_BYTES / seconds / 1e6 << " MB/s" << endl;
+    }
+
+    void printHistogram(const string& title, const map<int, size_t>& histogram, size_t total) {
+        cout << endl << title << endl;
+        for(const auto& entry : histogram) {
+            cout << setw(6) << entry.first << setw(12) << entry.second
+                 << setw(10) << fixed << setprecision(2) << 100.0 * entry.second / total << " %" << endl;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    string filename = argc > 1 ? argv[1] : "../blocksOut/coefficients.dump";
+    int iterations = argc > 2 ? stoi(argv[2]) : 5;
+
+    auto dump = CoefficientDump::read(filename);
+    vector<Block> blocks;
+    blocks.reserve(dump.types.size());
+    for(size_t i=0; i<dump.types.size(); i++) {
+        blocks.emplace_back(Block::zigZagReverse(dump.zigZagValues[i]));
+        blocks.back().setType(dump.types[i]);
+    }
+    cout << blocks.size() << " blocks, " << iterations << " iterations" << endl << endl;
+
+    // Block::entropy_encode
+    vector<ACCoefficient> symbols;
+    auto start = Clock::now();
+    for(int it=0; it<iterations; it++) {
+        symbols.clear();
+        for(const auto& block : blocks) {
+            auto encoded = block.entropy_encode();
+            symbols.insert(symbols.end(), encoded.begin(), encoded.end());
+        }
+    }
+    printRate("entropy_encode", secondsSince(start) / iterations, symbols.size(), blocks.size());
+
+    // EntropyDecoder over the same symbols
+    vector<int> zigZagValues;
+    start = Clock::now();
+    for(int it=0; it<iterations; it++) {
+        EntropyDecoder decoder{symbols};
+        while(decoder.decodeNext(zigZagValues)) {
+        }
+    }
+    printRate("entropy_decode", secondsSince(start) / iterations, symbols.size(), blocks.size());
+
+    // every entropy mode through the common interface, per plane and for the interleaved stream
+    size_t planeBlocks[3] = {0, 0, 0};
+    for(auto type : dump.types) {
+        planeBlocks[type]++;
+    }
+
+    for(auto mode : {RUN_LENGTH, ARITHMETIC}) {
+        string name = mode == RUN_LENGTH ? "run-length" : "arithmetic";
+        auto coder = EntropyCoder::create(mode, dump.blocksPerRow);
+
+        vector<unsigned char> bytes;
+        start = Clock::now();
+        for(int it=0; it<iterations; it++) {
+            for(const auto& block : blocks) {
+                coder->encodeBlock(block);
+            }
+            bytes = coder->finish();
+        }
+        printRate(name + " encode", secondsSince(start) / iterations, symbols.size(), blocks.size());
+
+        start = Clock::now();
+        for(int it=0; it<iterations; it++) {
+            coder->startDecoding(bytes.data(), bytes.size());
+            for(auto type : dump.types) {
+                coder->decodeBlock(type, zigZagValues);
+            }
+        }
+        printRate(name + " decode", secondsSince(start) / iterations, symbols.size(), blocks.size());
+
+        for(int plane=0; plane<3; plane++) {
+            auto planeCoder = EntropyCoder::create(mode, dump.blocksPerRow);
+            for(const auto& block : blocks) {
+                if(block.type == plane) {
+                    planeCoder->encodeBlock(block);
+                }
+            }
+            auto planeBytes = planeCoder->finish().size();
+            cout << "    " << setw(3) << PLANE_NAMES[plane] << ": " << setw(10) << planeBytes * 8 << " bits, "
+                 << fixed << setprecision(2) << planeBytes * 8.0 / max<size_t>(planeBlocks[plane], 1) << " bits/block" << endl;
+        }
+        cout << "    total: " << bytes.size() * 8 << " bits" << endl;
+    }
+
+    // symbol statistics
+    map<int, size_t> runLengths, sizeCategories;
+    size_t endOfBlocks = 0, acSymbols = 0;
+    size_t zeroBlocks = 0, dcOnlyBlocks = 0;
+
+    for(const auto& values : dump.zigZagValues) {
+        bool acZero = true;
+        for(int i=1; i<64; i++) {
+            acZero = acZero && values[i] == 0;
+        }
+        dcOnlyBlocks += acZero;
+        zeroBlocks += acZero && values[0] == 0;
+    }
+
+    size_t blockIdx = 0;
+    for(size_t i=0; i<symbols.size(); blockIdx++) {
+        // the first symbol of every block holds the DC value
+        sizeCategories[symbols[i].dcCoefficient.size]++;
+        size_t filled = 1;
+        i++;
+
+        while(filled < 64) {
+            const auto& symbol = symbols[i++];
+            filled += symbol.runlength;
+            if(symbol.dcCoefficient.amplitude == Block::END_OF_BLOCK) {
+                endOfBlocks++;
+                continue;
+            }
+            filled++;
+            acSymbols++;
+            runLengths[symbol.runlength]++;
+            sizeCategories[symbol.dcCoefficient.size]++;
+        }
+    }
+
+    cout << endl << "symbols: " << symbols.size() << " (" << acSymbols << " AC, " << endOfBlocks << " end of block)"
+         << endl << "symbols/block: " << fixed << setprecision(2) << double(symbols.size()) / blocks.size()
+         << endl << "zero blocks: " << 100.0 * zeroBlocks / blocks.size() << " %"
+         << endl << "DC-only blocks: " << 100.0 * dcOnlyBlocks / blocks.size() << " %" << endl;
+
+    printHistogram("run length histogram (AC symbols):", runLengths, max<size_t>(acSymbols, 1));
+    printHistogram("size category histogram (all symbols):", sizeCategories, max<size_t>(acSymbols + blockIdx, 1));
+
+    return 0;
+}
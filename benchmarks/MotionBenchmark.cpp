@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include "../encodingUtils/BlockCost.hpp"
+#include "../encodingUtils/Frame.hpp"
+#include "../encodingUtils/Interpolation.hpp"
+
+using namespace std;
+
+/**
+ * Motion search cost kernel benchmark.
+ *
+ * Usage: motion_benchmark [candidates]
+ * Evaluates every kernel on the same candidate positions of a pair of 800x600 luma planes, checks the SSE2 kernels
+ * against the scalar reference and reports candidate evaluations per second. The half sample interpolation filter
+ * is checked the same way on whole planes.
+ */
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+    using Kernel = std::function<int(const unsigned char*, int, const unsigned char*, int)>;
+
+    const int WIDTH = 800;
+    const int HEIGHT = 600;
+
+    class Candidate {
+    public:
+        int top, left, refTop, refLeft;
+    };
+
+    long long run(const string& name, const Kernel& kernel, const Plane& current, const Plane& reference,
+                  const vector<Candidate>& candidates) {
+        long long checksum = 0;
+        auto start = Clock::now();
+        for(const auto& c : candidates) {
+            checksum += kernel(current.row(c.top) + c.left, current.stride,
+                               reference.row(c.refTop) + c.refLeft, reference.stride);
+        }
+        double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+        cout << left << setw(20) << name << right << setw(10) << fixed << setprecision(2)
+             << candidates.size() / seconds / 1e6 << " Mcandidates/s" << endl;
+        return checksum;
+    }
+
+    using Filter = std::function<void(const unsigned char* const*, unsigned char*, int)>;
+
+    /**
+     * Filter the vertical half sample positions of a plane, like InterpolatedPlane::interpolate
+     */
+    Plane runFilter(const string& name, const Filter& filter, const Plane& source, int repetitions) {
+        Plane output{source.width, source.height};
+        auto start = Clock::now();
+        for(int repetition=0; repetition<repetitions; repetition++) {
+            for(int r=0; r<source.height; r++) {
+                const unsigned char* taps[6];
+                for(int k=0; k<6; k++) {
+                    taps[k] = source.row(min(source.height - 1, max(0, r + k - 2)));
+                }
+                filter(taps, output.row(r), source.width);
+            }
+        }
+        double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+        cout << left << setw(20) << name << right << setw(10) << fixed << setprecision(2)
+             << static_cast<double>(source.width) * source.height * repetitions / seconds / 1e6 << " Msamples/s" << endl;
+        return output;
+    }
+
+    bool samePlanes(const Plane& a, const Plane& b) {
+        for(int i=0; i<a.height; i++) {
+            if(not equal(a.row(i), a.row(i) + a.width, b.row(i))) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? stoul(argv[1]) : 2000000;
+
+    // a smooth reference and a noisy copy of it, so costs are in the range of real motion search
+    mt19937 rng(42);
+    Plane reference{WIDTH, HEIGHT}, current{WIDTH, HEIGHT};
+    for(int i=0; i<HEIGHT; i++) {
+        for(int j=0; j<WIDTH; j++) {
+            reference(i, j) = static_cast<unsigned char>((i * 3 + j * 2 + rng() % 16) & 0xFF);
+            current(i, j) = static_cast<unsigned char>(min(255, max(0, reference(i, j) + static_cast<int>(rng() % 9) - 4)));
+        }
+    }
+
+    vector<Candidate> candidates(count);
+    for(auto& c : candidates) {
+        c.top = static_cast<int>(rng() % (HEIGHT - 16));
+        c.left = static_cast<int>(rng() % (WIDTH - 16));
+        c.refTop = min(HEIGHT - 16, max(0, c.top + static_cast<int>(rng() % 33) - 16));
+        c.refLeft = min(WIDTH - 16, max(0, c.left + static_cast<int>(rng() % 33) - 16));
+    }
+
+    cout << count << " candidates" << endl << endl;
+
+    auto scalar = [](int size, bool satd) -> Kernel {
+        return [size, satd](const unsigned char* a, int aStride, const unsigned char* b, int bStride) {
+            return satd ? BlockCost::satdScalar(a, aStride, b, bStride, size)
+                        : BlockCost::sadScalar(a, aStride, b, bStride, size);
+        };
+    };
+
+    bool matching = true;
+    matching &= run("sad8x8 scalar", scalar(8, false), current, reference, candidates)
+             == run("sad8x8", BlockCost::sad8x8, current, reference, candidates);
+    matching &= run("sad16x16 scalar", scalar(16, false), current, reference, candidates)
+             == run("sad16x16", BlockCost::sad16x16, current, reference, candidates);
+    matching &= run("satd8x8 scalar", scalar(8, true), current, reference, candidates)
+             == run("satd8x8", BlockCost::satd8x8, current, reference, candidates);
+    matching &= run("satd16x16 scalar", scalar(16, true), current, reference, candidates)
+             == run("satd16x16", BlockCost::satd16x16, current, reference, candidates);
+
+    cout << endl;
+    int repetitions = static_cast<int>(max<size_t>(1, count / 20000));
+    auto scalarHalfSamples = runFilter("half sample scalar", InterpolatedPlane::filterRowScalar, reference, repetitions);
+    auto halfSamples = runFilter("half sample", InterpolatedPlane::filterRow, reference, repetitions);
+    matching &= samePlanes(scalarHalfSamples, halfSamples);
+
+    cout << endl << (matching ? "all kernels match the scalar reference" : "MISMATCH against the scalar reference")
+         << endl;
+    return matching ? 0 : 1;
+}
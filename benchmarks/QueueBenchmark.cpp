@@ -0,0 +1,99 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../encodingUtils/BoundedQueue.hpp"
+#include "../encodingUtils/RingBuffer.hpp"
+
+using namespace std;
+
+/**
+ * Stage handoff benchmark.
+ *
+ * Usage: queue_benchmark [items] [capacity]
+ * Producers push the numbers 1 to items through a queue, consumers pop and sum them. Every queue between the codec
+ * stages runs with 1, 2 and 4 producers and consumers, the sum is checked and the time per item is reported.
+ */
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @return true if the consumers popped every item exactly once
+     */
+    template<class Queue>
+    bool run(const string& name, Queue& queue, unsigned producers, unsigned consumers, uint64_t items) {
+        vector<thread> threads;
+        vector<uint64_t> sums(consumers, 0);
+        atomic<unsigned> remaining{producers};
+
+        auto start = Clock::now();
+        for(unsigned p=0; p<producers; p++) {
+            threads.emplace_back([&, p]() {
+                // producer p pushes every producers-th number
+                for(uint64_t item=p + 1; item<=items; item+=producers) {
+                    queue.push(item);
+                }
+                if(--remaining == 0) {
+                    queue.close();
+                }
+            });
+        }
+        for(unsigned c=0; c<consumers; c++) {
+            threads.emplace_back([&, c]() {
+                uint64_t item, sum = 0;
+                while(queue.pop(item)) {
+                    sum += item;
+                }
+                sums[c] = sum;
+            });
+        }
+        for(auto& t : threads) {
+            t.join();
+        }
+        double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+        uint64_t total = 0;
+        for(auto sum : sums) {
+            total += sum;
+        }
+        bool correct = total == items * (items + 1) / 2;
+
+        cout << left << setw(16) << name << producers << "P" << consumers << "C" << right
+             << setw(12) << fixed << setprecision(1) << seconds * 1e9 / items << " ns/item"
+             << (correct ? "" : "   WRONG SUM") << endl;
+        return correct;
+    }
+}
+
+int main(int argc, char** argv) {
+    uint64_t items = argc > 1 ? stoull(argv[1]) : 2000000;
+    size_t capacity = argc > 2 ? stoul(argv[2]) : 1024;
+
+    cout << items << " items, capacity " << capacity << ", " << thread::hardware_concurrency() << " hardware threads"
+         << endl << endl;
+
+    bool correct = true;
+    for(unsigned threads : {1U, 2U, 4U}) {
+        if(threads == 1) {
+            for(auto mode : {SPIN_WAIT, BLOCK_WAIT}) {
+                SpscRing<uint64_t> ring{capacity, mode};
+                correct &= run(mode == SPIN_WAIT ? "spsc spin" : "spsc block", ring, 1, 1, items);
+            }
+        }
+        for(auto mode : {SPIN_WAIT, BLOCK_WAIT}) {
+            MpmcRing<uint64_t> ring{capacity, mode};
+            correct &= run(mode == SPIN_WAIT ? "mpmc spin" : "mpmc block", ring, threads, threads, items);
+        }
+        BoundedQueue<uint64_t> queue{capacity};
+        correct &= run("mutex", queue, threads, threads, items);
+        cout << endl;
+    }
+
+    cout << (correct ? "every item was popped once" : "MISMATCH in the popped items") << endl;
+    return correct ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include "../encodingUtils/StreamCodec.hpp"
+
+using namespace std;
+
+/**
+ * Coroutine stream benchmark.
+ *
+ * Usage: stream_benchmark [streams] [frames] [threads]
+ * Encodes and then decodes many small streams at the same time, every stream a coroutine on a pool of a few threads.
+ * The decoded frames are checked against a plain VideoEncoder and VideoDecoder run on the same frames.
+ */
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    const int WIDTH = 64;
+    const int HEIGHT = 48;
+
+    /**
+     * A textured pattern moving by a few samples per frame, different for every stream
+     */
+    vector<Frame> makeFrames(int stream, int count) {
+        mt19937 rng(stream);
+        vector<unsigned char> texture(4 * WIDTH * 4 * HEIGHT);
+        for(auto& sample : texture) {
+            sample = static_cast<unsigned char>(rng() % 256);
+        }
+        int dx = 1 + stream % 3, dy = stream % 2;
+
+        vector<Frame> frames;
+        for(int f=0; f<count; f++) {
+            Frame frame{WIDTH, HEIGHT};
+            frame.frameNumber = f;
+            auto sample = [&](int i, int j) {
+                return texture[(i + f * dy) % (4 * HEIGHT) * 4 * WIDTH + (j + f * dx) % (4 * WIDTH)];
+            };
+            for(int i=0; i<HEIGHT; i++) {
+                for(int j=0; j<WIDTH; j++) {
+                    frame.y(i, j) = sample(i, j);
+                }
+            }
+            for(int i=0; i<HEIGHT / 2; i++) {
+                for(int j=0; j<WIDTH / 2; j++) {
+                    frame.cb(i, j) = sample(2 * i, 2 * j) / 2 + 64;
+                    frame.cr(i, j) = sample(2 * i + 1, 2 * j + 1) / 2 + 64;
+                }
+            }
+            frames.push_back(move(frame));
+        }
+        return frames;
+    }
+
+    Task<void> encodeStream(StreamEncoder& encoder, const vector<Frame>& frames, vector<EncodedFrame>& packets) {
+        for(const auto& frame : frames) {
+            auto finished = co_await encoder.push(frame);
+            move(finished.begin(), finished.end(), back_inserter(packets));
+        }
+        auto rest = co_await encoder.flush();
+        move(rest.begin(), rest.end(), back_inserter(packets));
+    }
+
+    Task<void> feedStream(StreamDecoder& decoder, const vector<EncodedFrame>& packets) {
+        for(const auto& packet : packets) {
+            co_await decoder.push(packet);
+        }
+        decoder.close();
+    }
+
+    Task<void> readStream(StreamDecoder& decoder, vector<shared_ptr<const Frame>>& frames) {
+        while(auto frame = co_await decoder.next()) {
+            frames.push_back(move(frame));
+        }
+    }
+
+    bool sameFrames(const Frame& a, const Frame& b) {
+        auto samePlanes = [](const Plane& p, const Plane& q) {
+            for(int i=0; i<p.height; i++) {
+                if(not equal(p.row(i), p.row(i) + p.width, q.row(i))) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        return a.frameNumber == b.frameNumber && samePlanes(a.y, b.y) && samePlanes(a.cb, b.cb)
+               && samePlanes(a.cr, b.cr);
+    }
+
+    double secondsSince(Clock::time_point start) {
+        return chrono::duration<double>(Clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv) {
+    int streamCount = argc > 1 ? stoi(argv[1]) : 64;
+    int frameCount = argc > 2 ? stoi(argv[2]) : 12;
+    unsigned threads = argc > 3 ? static_cast<unsigned>(stoi(argv[3])) : max(2U, thread::hardware_concurrency());
+
+    EncoderSettings settings;
+    settings.bFrames = 2;
+    settings.lookahead = 3;
+    settings.keyframeInterval = 8;
+
+    vector<vector<Frame>> inputs;
+    for(int s=0; s<streamCount; s++) {
+        inputs.push_back(makeFrames(s, frameCount));
+    }
+    cout << streamCount << " streams of " << frameCount << " " << WIDTH << "x" << HEIGHT << " frames, " << threads
+         << " threads" << endl << endl;
+
+    ThreadPool pool{max(2U, threads)};
+    vector<vector<EncodedFrame>> packets(streamCount);
+    vector<vector<shared_ptr<const Frame>>> decoded(streamCount);
+
+    auto start = Clock::now();
+    {
+        vector<unique_ptr<StreamEncoder>> encoders;
+        TaskGroup group;
+        for(int s=0; s<streamCount; s++) {
+            encoders.push_back(make_unique<StreamEncoder>(settings, pool));
+            group.spawn(encodeStream(*encoders.back(), inputs[s], packets[s]));
+        }
+        group.wait();
+    }
+    double encodeSeconds = secondsSince(start);
+
+    start = Clock::now();
+    {
+        vector<unique_ptr<StreamDecoder>> decoders;
+        TaskGroup group;
+        for(int s=0; s<streamCount; s++) {
+            decoders.push_back(make_unique<StreamDecoder>(pool));
+            group.spawn(readStream(*decoders.back(), decoded[s]));
+            group.spawn(feedStream(*decoders.back(), packets[s]));
+        }
+        group.wait();
+    }
+    double decodeSeconds = secondsSince(start);
+
+    double totalFrames = static_cast<double>(streamCount) * frameCount;
+    cout << left << setw(10) << "encode" << right << setw(10) << fixed << setprecision(1)
+         << totalFrames / encodeSeconds << " frames/s" << endl;
+    cout << left << setw(10) << "decode" << right << setw(10) << fixed << setprecision(1)
+         << totalFrames / decodeSeconds << " frames/s" << endl;
+
+    // the same streams through a plain encoder and decoder, one after the other
+    bool matching = true;
+    for(int s=0; s<streamCount; s++) {
+        VideoEncoder encoder{settings};
+        VideoDecoder decoder;
+        vector<shared_ptr<const Frame>> expected;
+        auto decode = [&](const vector<EncodedFrame>& coded) {
+            for(const auto& packet : coded) {
+                auto frames = decoder.push(packet);
+                move(frames.begin(), frames.end(), back_inserter(expected));
+            }
+        };
+        for(const auto& frame : inputs[s]) {
+            decode(encoder.push(frame));
+        }
+        decode(encoder.flush());
+        auto rest = decoder.flush();
+        move(rest.begin(), rest.end(), back_inserter(expected));
+
+        matching &= expected.size() == decoded[s].size();
+        for(size_t f=0; matching && f<expected.size(); f++) {
+            matching &= sameFrames(*expected[f], *decoded[s][f]);
+        }
+    }
+
+    cout << endl << (matching ? "every stream matches the plain encoder and decoder" : "MISMATCH against the plain encoder and decoder")
+         << endl;
+    return matching ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "../ImageUtils/Image.hpp"
+#include "../encodingUtils/EntropyCoder.hpp"
+#include "../encodingUtils/TiledFrame.hpp"
+
+using namespace std;
+
+/**
+ * Tiled entropy coding benchmark.
+ *
+ * Usage: tile_benchmark [image] [iterations]
+ * Codes the blocks of the image with every entropy mode as one frame and as grids of tiles, on every thread of a
+ * pool. Reports the coded size and the encode and decode rates. Checks that the tiles decode to the blocks of
+ * EntropyCoder::decodeFrame, that decodeRegion leaves only the tiles outside the region empty, and that a truncated
+ * tile throws.
+ */
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+    using DecodedBlocks = tuple<vector<Block*>, vector<Block*>, vector<Block*>>;
+
+    double secondsSince(Clock::time_point start) {
+        return chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    void freeBlocks(DecodedBlocks& blocks) {
+        for(auto component : {&get<0>(blocks), &get<1>(blocks), &get<2>(blocks)}) {
+            for(auto block : *component) {
+                delete block;
+            }
+        }
+    }
+
+    /**
+     * @param decodedOnly Skip the blocks the output does not hold
+     * @return Whether the output holds the blocks of the reference
+     */
+    bool sameBlocks(const DecodedBlocks& output, const DecodedBlocks& reference, bool decodedOnly) {
+        const vector<Block*>* outputs[3] = {&get<0>(output), &get<1>(output), &get<2>(output)};
+        const vector<Block*>* references[3] = {&get<0>(reference), &get<1>(reference), &get<2>(reference)};
+        for(int c=0; c<3; c++) {
+            if(outputs[c]->size() != references[c]->size()) {
+                return false;
+            }
+            for(size_t i=0; i<outputs[c]->size(); i++) {
+                auto block = (*outputs[c])[i];
+                if(block == nullptr ? not decodedOnly
+                                    : block->type != (*references[c])[i]->type
+                                      || block->values != (*references[c])[i]->values) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @return Whether exactly the blocks of the tiles overlapping the region were decoded
+     */
+    bool decodedRegion(const TiledFrame& frame, const DecodedBlocks& output, int top, int left, int rows,
+                       int columns) {
+        for(int tileRow=0; tileRow<frame.tileRows; tileRow++) {
+            bool rowInside = frame.rowStart(tileRow + 1) > top && frame.rowStart(tileRow) < top + rows;
+            for(int tileColumn=0; tileColumn<frame.tileColumns; tileColumn++) {
+                bool inside = rowInside && frame.columnStart(tileColumn + 1) > left
+                              && frame.columnStart(tileColumn) < left + columns;
+                for(int row=frame.rowStart(tileRow); row<frame.rowStart(tileRow + 1); row++) {
+                    for(int column=frame.columnStart(tileColumn); column<frame.columnStart(tileColumn + 1); column++) {
+                        if((get<0>(output)[row * frame.blocksPerRow + column] != nullptr) != inside) {
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @return Whether decoding throws once the last tile lost half of its bytes
+     */
+    bool rejectsTruncatedTile(TiledFrame frame, ThreadPool& pool) {
+        size_t lastTile = frame.tileOffsets.back();
+        frame.bytes.resize(lastTile + (frame.bytes.size() - lastTile) / 2);
+        try {
+            auto decoded = frame.decode(pool);
+            freeBlocks(decoded);
+            return false;
+        }
+        catch(const runtime_error&) {
+            return true;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    string filename = argc > 1 ? argv[1] : "../image.ppm";
+    int iterations = argc > 2 ? stoi(argv[2]) : 5;
+
+    ThreadPool pool{max(2U, thread::hardware_concurrency())};
+    auto image = Image{filename};
+    auto blocks = image.encode(pool);
+    int blocksPerRow = image.getWidth() / 8;
+    int blockRows = static_cast<int>(get<0>(blocks).size()) / blocksPerRow;
+    cout << blocksPerRow << "x" << blockRows << " blocks, " << pool.size() << " threads, " << iterations
+         << " iterations" << endl << endl;
+
+    // the region decoded on its own, the middle of the frame
+    int regionTop = blockRows / 4, regionLeft = blocksPerRow / 4;
+    int regionRows = blockRows / 2, regionColumns = blocksPerRow / 2;
+    const pair<int, int> grids[] = {{1, 1}, {2, 2}, {4, 3}, {8, 6}};
+
+    bool matching = true;
+    for(auto mode : {RUN_LENGTH, ARITHMETIC}) {
+        auto single = EntropyCoder::encodeFrame(blocks, blocksPerRow, mode);
+        auto reference = EntropyCoder::decodeFrame(single);
+        cout << (mode == RUN_LENGTH ? "run-length" : "arithmetic") << ", " << single.bytes.size()
+             << " bytes as one frame" << endl;
+
+        for(const auto& grid : grids) {
+            TiledFrame frame;
+            auto start = Clock::now();
+            for(int it=0; it<iterations; it++) {
+                frame = TiledFrame::encode(blocks, blocksPerRow, grid.first, grid.second, mode, pool);
+            }
+            double encodeSeconds = secondsSince(start) / iterations;
+
+            DecodedBlocks decoded;
+            start = Clock::now();
+            for(int it=0; it<iterations; it++) {
+                freeBlocks(decoded);
+                decoded = frame.decode(pool);
+            }
+            double decodeSeconds = secondsSince(start) / iterations;
+
+            cout << setw(4) << frame.tileColumns << "x" << left << setw(3) << frame.tileRows << right
+                 << setw(10) << frame.bytes.size() << " bytes" << setw(8) << fixed << setprecision(2)
+                 << 100.0 * frame.bytes.size() / single.bytes.size() - 100 << " %"
+                 << setw(10) << setprecision(1) << 1 / encodeSeconds << " encodes/s"
+                 << setw(10) << 1 / decodeSeconds << " decodes/s";
+
+            if(not sameBlocks(decoded, reference, false)) {
+                cout << " (tiles differ from the frame)";
+                matching = false;
+            }
+            freeBlocks(decoded);
+
+            auto region = frame.decodeRegion(regionTop, regionLeft, regionRows, regionColumns, pool);
+            if(not sameBlocks(region, reference, true)
+               || not decodedRegion(frame, region, regionTop, regionLeft, regionRows, regionColumns)) {
+                cout << " (wrong region)";
+                matching = false;
+            }
+            freeBlocks(region);
+
+            if(not rejectsTruncatedTile(frame, pool)) {
+                cout << " (truncated tile decoded)";
+                matching = false;
+            }
+            cout << endl;
+        }
+        freeBlocks(reference);
+        cout << endl;
+    }
+
+    cout << (matching ? "every grid decodes to the blocks of the frame" : "MISMATCH between tiles and frame") << endl;
+    return matching ? 0 : 1;
+}
@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include "../encodingUtils/VideoDecoder.hpp"
+#include "../encodingUtils/VideoEncoder.hpp"
+
+using namespace std;
+
+/**
+ * Wavefront encoder benchmark.
+ *
+ * Usage: wavefront_benchmark [frames] [threads]
+ * Encodes the same frames with every search strategy, with B frames and with row rate control, on 1 thread and on
+ * 2, 4, ... up to the given number of threads. Reports frames per second. Checks that every thread count gives the
+ * same packets as a single thread, and that the lossless streams decode back to the input frames.
+ */
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    const int WIDTH = 256;
+    const int HEIGHT = 192;
+
+    class Configuration {
+    public:
+        string name;
+        EncoderSettings settings;
+    };
+
+    /**
+     * A noisy texture panning by one or two samples per frame, with a square moving against the pan
+     */
+    vector<Frame> makeFrames(int count) {
+        mt19937 rng(7);
+        vector<unsigned char> texture(2 * WIDTH * 2 * HEIGHT);
+        for(int i=0; i<2 * HEIGHT; i++) {
+            for(int j=0; j<2 * WIDTH; j++) {
+                texture[i * 2 * WIDTH + j] = static_cast<unsigned char>((i * 5 + j * 3 + rng() % 48) & 0xFF);
+            }
+        }
+
+        vector<Frame> frames;
+        for(int f=0; f<count; f++) {
+            Frame frame{WIDTH, HEIGHT};
+            frame.frameNumber = f;
+            int panX = f * 3 / 2, panY = f / 2;
+            for(int i=0; i<HEIGHT; i++) {
+                for(int j=0; j<WIDTH; j++) {
+                    frame.y(i, j) = texture[(i + panY) % (2 * HEIGHT) * 2 * WIDTH + (j + panX) % (2 * WIDTH)];
+                }
+            }
+            int squareLeft = WIDTH - 32 - 1 - 3 * f % (WIDTH - 32);
+            for(int i=64; i<96; i++) {
+                for(int j=0; j<32; j++) {
+                    frame.y(i, squareLeft + j) = static_cast<unsigned char>(40 + (i * j) % 32);
+                }
+            }
+            for(int i=0; i<HEIGHT / 2; i++) {
+                for(int j=0; j<WIDTH / 2; j++) {
+                    frame.cb(i, j) = static_cast<unsigned char>(frame.y(2 * i, 2 * j) / 2 + 64);
+                    frame.cr(i, j) = static_cast<unsigned char>(frame.y(2 * i + 1, 2 * j + 1) / 3 + 80);
+                }
+            }
+            frames.push_back(move(frame));
+        }
+        return frames;
+    }
+
+    vector<EncodedFrame> encode(const EncoderSettings& settings, const vector<Frame>& frames) {
+        VideoEncoder encoder{settings};
+        vector<EncodedFrame> packets;
+        for(const auto& frame : frames) {
+            auto finished = encoder.push(frame);
+            move(finished.begin(), finished.end(), back_inserter(packets));
+        }
+        auto rest = encoder.flush();
+        move(rest.begin(), rest.end(), back_inserter(packets));
+        return packets;
+    }
+
+    bool sameVectors(const vector<MotionVector>& a, const vector<MotionVector>& b) {
+        return equal(a.begin(), a.end(), b.begin(), b.end(), [](const MotionVector& p, const MotionVector& q) {
+            return p.dx == q.dx && p.dy == q.dy;
+        });
+    }
+
+    bool samePackets(const EncodedFrame& a, const EncodedFrame& b) {
+        bool sameCoefficients = equal(a.coefficients.begin(), a.coefficients.end(), b.coefficients.begin(),
+                                      b.coefficients.end(), [](const ACCoefficient& p, const ACCoefficient& q) {
+            return p.runlength == q.runlength && p.dcCoefficient.amplitude == q.dcCoefficient.amplitude;
+        });
+        return a.type == b.type && a.frameNumber == b.frameNumber && a.quantizer == b.quantizer
+               && a.rowQuantizers == b.rowQuantizers && a.skipFlags == b.skipFlags && a.directions == b.directions
+               && sameVectors(a.motionVectors, b.motionVectors) && sameVectors(a.backwardVectors, b.backwardVectors)
+               && sameCoefficients;
+    }
+
+    bool sameStreams(const vector<EncodedFrame>& a, const vector<EncodedFrame>& b) {
+        return equal(a.begin(), a.end(), b.begin(), b.end(), samePackets);
+    }
+
+    /**
+     * @return Whether the packets decode to exactly the input frames, in display order
+     */
+    bool decodesToInput(const vector<EncodedFrame>& packets, const vector<Frame>& frames) {
+        VideoDecoder decoder;
+        vector<shared_ptr<const Frame>> decoded;
+        for(const auto& packet : packets) {
+            auto finished = decoder.push(packet);
+            move(finished.begin(), finished.end(), back_inserter(decoded));
+        }
+        auto rest = decoder.flush();
+        move(rest.begin(), rest.end(), back_inserter(decoded));
+
+        auto samePlanes = [](const Plane& p, const Plane& q) {
+            for(int i=0; i<p.height; i++) {
+                if(not equal(p.row(i), p.row(i) + p.width, q.row(i))) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        bool matching = decoded.size() == frames.size();
+        for(size_t f=0; matching && f<frames.size(); f++) {
+            const auto& frame = *decoded[f];
+            matching = frame.frameNumber == frames[f].frameNumber && samePlanes(frame.y, frames[f].y)
+                       && samePlanes(frame.cb, frames[f].cb) && samePlanes(frame.cr, frames[f].cr);
+        }
+        return matching;
+    }
+}
+
+int main(int argc, char** argv) {
+    int frameCount = argc > 1 ? stoi(argv[1]) : 12;
+    unsigned maxThreads = argc > 2 ? static_cast<unsigned>(stoi(argv[2])) : 8;
+
+    vector<Configuration> configurations;
+    const pair<const char*, SearchStrategy> strategies[] = {{"full", FULL_SEARCH}, {"diamond", DIAMOND_SEARCH},
+                                                            {"hexagon", HEXAGON_SEARCH}, {"pyramid", PYRAMID_SEARCH}};
+    for(const auto& strategy : strategies) {
+        Configuration configuration{strategy.first, EncoderSettings{}};
+        configuration.settings.searchStrategy = strategy.second;
+        configuration.settings.keyframeInterval = 8;
+        configurations.push_back(configuration);
+    }
+    Configuration bFrames{"b frames", EncoderSettings{}};
+    bFrames.settings.bFrames = 2;
+    bFrames.settings.lookahead = 3;
+    configurations.push_back(bFrames);
+    for(bool rowRateControl : {false, true}) {
+        Configuration bitrate{rowRateControl ? "cbr rows" : "cbr", EncoderSettings{}};
+        bitrate.settings.rateControl = CONSTANT_BITRATE;
+        bitrate.settings.targetBitrate = 2000000;
+        bitrate.settings.rowRateControl = rowRateControl;
+        bitrate.settings.bFrames = 2;
+        bitrate.settings.lookahead = 3;
+        configurations.push_back(bitrate);
+    }
+
+    auto frames = makeFrames(frameCount);
+    cout << frameCount << " " << WIDTH << "x" << HEIGHT << " frames, frames/s by thread count" << endl << endl;
+
+    bool matching = true;
+    for(const auto& configuration : configurations) {
+        cout << left << setw(10) << configuration.name << right;
+        vector<EncodedFrame> reference;
+        for(unsigned threads=1; threads<=max(1U, maxThreads); threads*=2) {
+            auto settings = configuration.settings;
+            settings.threads = threads;
+
+            auto start = Clock::now();
+            auto packets = encode(settings, frames);
+            double seconds = chrono::duration<double>(Clock::now() - start).count();
+            cout << setw(6) << threads << ":" << setw(8) << fixed << setprecision(1) << frameCount / seconds;
+
+            if(threads == 1) {
+                reference = move(packets);
+                if(settings.quantizer == 1 && settings.rateControl == CONSTANT_QUALITY
+                   && not decodesToInput(reference, frames)) {
+                    cout << " (does not decode to the input)";
+                    matching = false;
+                }
+            }
+            else if(not sameStreams(packets, reference)) {
+                cout << " (differs from 1 thread)";
+                matching = false;
+            }
+        }
+        cout << endl;
+    }
+
+    cout << endl << (matching ? "every thread count gives the packets of a single thread"
+                              : "MISMATCH between thread counts") << endl;
+    return matching ? 0 : 1;
+}
@@ -0,0 +1,303 @@
+#include <algorithm>
+#include "ArithmeticCoder.hpp"
+
+using namespace std;
+
+namespace {
+    const int PROBABILITY_BITS = 11;
+    const uint16_t PROBABILITY_ONE = 1 << PROBABILITY_BITS;
+    const int ADAPTATION_SHIFT = 5;
+    const uint32_t TOP = 1 << 24;
+}
+
+void RangeEncoder::encodeBit(uint16_t& probability, int bit) {
+    uint32_t bound = (range >> PROBABILITY_BITS) * probability;
+
+    if(bit == 0) {
+        range = bound;
+        probability += (PROBABILITY_ONE - probability) >> ADAPTATION_SHIFT;
+    }
+    else {
+        low += bound;
+        range -= bound;
+        probability -= probability >> ADAPTATION_SHIFT;
+    }
+
+    while(range < TOP) {
+        range <<= 8;
+        shiftLow();
+    }
+}
+
+void RangeEncoder::encodeBypass(uint32_t value, int bitCount) {
+    for(int i=bitCount-1; i>=0; i--) {
+        range >>= 1;
+        if((value >> i) & 1) {
+            low += range;
+        }
+
+        while(range < TOP) {
+            range <<= 8;
+            shiftLow();
+        }
+    }
+}
+
+void RangeEncoder::shiftLow() {
+    // a byte can only be written once no carry can reach it anymore
+    if(static_cast<uint32_t>(low) < 0xFF000000 || (low >> 32) != 0) {
+        auto carry = static_cast<unsigned char>(low >> 32);
+        unsigned char temp = cache;
+        do {
+            bytes.push_back(static_cast<unsigned char>(temp + carry));
+            temp = 0xFF;
+        } while(--cacheSize != 0);
+        cache = static_cast<unsigned char>(low >> 24);
+    }
+    cacheSize++;
+    low = (low & 0x00FFFFFF) << 8;
+}
+
+std::vector<unsigned char> RangeEncoder::finish() {
+    for(int i=0; i<5; i++) {
+        shiftLow();
+    }
+
+    vector<unsigned char> output;
+    output.swap(bytes);
+
+    low = 0;
+    range = 0xFFFFFFFF;
+    cache = 0;
+    cacheSize = 1;
+    return output;
+}
+
+RangeDecoder::RangeDecoder(const unsigned char* data, size_t size): data{data}, size{size} {
+    for(int i=0; i<5; i++) {
+        code = (code << 8) | nextByte();
+    }
+}
+
+int RangeDecoder::decodeBit(uint16_t& probability) {
+    uint32_t bound = (range >> PROBABILITY_BITS) * probability;
+    int bit;
+
+    if(code < bound) {
+        range = bound;
+        probability += (PROBABILITY_ONE - probability) >> ADAPTATION_SHIFT;
+        bit = 0;
+    }
+    else {
+        code -= bound;
+        range -= bound;
+        probability -= probability >> ADAPTATION_SHIFT;
+        bit = 1;
+    }
+
+    while(range < TOP) {
+        range <<= 8;
+        code = (code << 8) | nextByte();
+    }
+    return bit;
+}
+
+uint32_t RangeDecoder::decodeBypass(int bitCount) {
+    uint32_t value = 0;
+
+    for(int i=0; i<bitCount; i++) {
+        range >>= 1;
+        int bit = 0;
+        if(code >= range) {
+            code -= range;
+            bit = 1;
+        }
+        value = (value << 1) | bit;
+
+        while(range < TOP) {
+            range <<= 8;
+            code = (code << 8) | nextByte();
+        }
+    }
+    return value;
+}
+
+void ArithmeticCoder::reset() {
+    for(auto& ctx : contexts) {
+        fill(begin(ctx.codedBlock), end(ctx.codedBlock), PROBABILITY_ONE / 2);
+        fill(begin(ctx.significant), end(ctx.significant), PROBABILITY_ONE / 2);
+        fill(begin(ctx.last), end(ctx.last), PROBABILITY_ONE / 2);
+        fill(begin(ctx.greaterThanOne), end(ctx.greaterThanOne), PROBABILITY_ONE / 2);
+        fill(begin(ctx.levelPrefix), end(ctx.levelPrefix), PROBABILITY_ONE / 2);
+    }
+
+    for(auto& flags : codedFlags) {
+        flags.clear();
+    }
+}
+
+/**
+ * Number of coded neighbours (left, above) of the next block of the given type
+ */
+int ArithmeticCoder::codedBlockContext(BlockType type) const {
+    const auto& flags = codedFlags[type];
+    auto idx = static_cast<int>(flags.size());
+
+    int left = idx % blocksPerRow > 0 ? flags[idx - 1] : 0;
+    int above = idx >= blocksPerRow ? flags[idx - blocksPerRow] : 0;
+    return left + above;
+}
+
+void ArithmeticCoder::encodeExpGolomb(uint32_t value) {
+    int k = 0;
+    while(value >= (1U << k)) {
+        encoder.encodeBypass(1, 1);
+        value -= 1U << k;
+        k++;
+    }
+    encoder.encodeBypass(0, 1);
+    encoder.encodeBypass(value, k);
+}
+
+uint32_t ArithmeticCoder::decodeExpGolomb() {
+    uint32_t value = 0;
+    int k = 0;
+    while(k < 24 && decoder.decodeBypass(1)) {
+        value += 1U << k;
+        k++;
+    }
+    return value + decoder.decodeBypass(k);
+}
+
+void ArithmeticCoder::encodeBlock(const Block& block) {
+    auto& ctx = contexts[block.type == Y ? 0 : 1];
+    vector<int> zigZagParsed = Block::zigZagParse(block);
+
+    int lastPosition = -1;
+    for(int i=63; i>=0; i--) {
+        if(zigZagParsed[i] != 0) {
+            lastPosition = i;
+            break;
+        }
+    }
+
+    // coded-block flag
+    int coded = lastPosition >= 0;
+    encoder.encodeBit(ctx.codedBlock[codedBlockContext(block.type)], coded);
+    codedFlags[block.type].push_back(static_cast<unsigned char>(coded));
+    if(not coded) {
+        return;
+    }
+
+    // significance map, the last flag follows every significant position. Position 63 is implied.
+    for(int pos=0; pos<63 && pos<=lastPosition; pos++) {
+        int significant = zigZagParsed[pos] != 0;
+        encoder.encodeBit(ctx.significant[pos], significant);
+        if(significant) {
+            encoder.encodeBit(ctx.last[pos], pos == lastPosition);
+        }
+    }
+
+    // levels in reverse scan order
+    int numEqualOne = 0, numGreaterOne = 0;
+    for(int pos=lastPosition; pos>=0; pos--) {
+        int value = zigZagParsed[pos];
+        if(value == 0) {
+            continue;
+        }
+
+        auto absLevel = static_cast<uint32_t>(abs(value));
+        int greaterOneCtx = numGreaterOne ? 0 : min(numEqualOne + 1, 4);
+        encoder.encodeBit(ctx.greaterThanOne[greaterOneCtx], absLevel > 1);
+
+        if(absLevel > 1) {
+            uint32_t remainder = absLevel - 2;
+            int prefixCtx = min(numGreaterOne, 4);
+            auto prefix = min(remainder, static_cast<uint32_t>(PREFIX_LIMIT));
+
+            for(uint32_t i=0; i<prefix; i++) {
+                encoder.encodeBit(ctx.levelPrefix[prefixCtx], 1);
+            }
+            if(prefix < PREFIX_LIMIT) {
+                encoder.encodeBit(ctx.levelPrefix[prefixCtx], 0);
+            }
+            else {
+                encodeExpGolomb(remainder - PREFIX_LIMIT);
+            }
+            numGreaterOne++;
+        }
+        else {
+            numEqualOne++;
+        }
+
+        encoder.encodeBypass(value < 0, 1);
+    }
+}
+
+std::vector<unsigned char> ArithmeticCoder::finish() {
+    reset();
+    return encoder.finish();
+}
+
+void ArithmeticCoder::startDecoding(const unsigned char* data, size_t size) {
+    reset();
+    decoder = RangeDecoder{data, size};
+}
+
+bool ArithmeticCoder::decodeBlock(BlockType type, std::vector<int>& zigZagValues) {
+    auto& ctx = contexts[type == Y ? 0 : 1];
+    zigZagValues.assign(64, 0);
+
+    int coded = decoder.decodeBit(ctx.codedBlock[codedBlockContext(type)]);
+    codedFlags[type].push_back(static_cast<unsigned char>(coded));
+    if(not coded) {
+        return not decoder.overrun();
+    }
+
+    // significance map
+    int positions[64];
+    int count = 0;
+    bool lastFound = false;
+    for(int pos=0; pos<63; pos++) {
+        if(decoder.decodeBit(ctx.significant[pos])) {
+            positions[count++] = pos;
+            if(decoder.decodeBit(ctx.last[pos])) {
+                lastFound = true;
+                break;
+            }
+        }
+    }
+    if(not lastFound) {
+        positions[count++] = 63;
+    }
+
+    // levels in reverse scan order
+    int numEqualOne = 0, numGreaterOne = 0;
+    for(int k=count-1; k>=0; k--) {
+        int greaterOneCtx = numGreaterOne ? 0 : min(numEqualOne + 1, 4);
+        uint32_t absLevel = 1;
+
+        if(decoder.decodeBit(ctx.greaterThanOne[greaterOneCtx])) {
+            int prefixCtx = min(numGreaterOne, 4);
+            uint32_t remainder = 0;
+
+            while(remainder < PREFIX_LIMIT && decoder.decodeBit(ctx.levelPrefix[prefixCtx])) {
+                remainder++;
+            }
+            if(remainder == PREFIX_LIMIT) {
+                remainder += decodeExpGolomb();
+            }
+
+            absLevel = remainder + 2;
+            numGreaterOne++;
+        }
+        else {
+            numEqualOne++;
+        }
+
+        int value = static_cast<int>(absLevel);
+        zigZagValues[positions[k]] = decoder.decodeBypass(1) ? -value : value;
+    }
+
+    return not decoder.overrun();
+}
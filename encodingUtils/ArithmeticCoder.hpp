@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include "EntropyCoder.hpp"
+
+/**
+ * Adaptive binary range coder.
+ * Probabilities are 11 bit estimates of a 0 bit, updated after every coded bit.
+ */
+class RangeEncoder {
+public:
+    void encodeBit(uint16_t& probability, int bit);
+    void encodeBypass(uint32_t value, int bitCount);
+    std::vector<unsigned char> finish();
+
+private:
+    void shiftLow();
+
+    uint64_t low = 0;
+    uint32_t range = 0xFFFFFFFF;
+    unsigned char cache = 0;
+    uint64_t cacheSize = 1;
+    std::vector<unsigned char> bytes;
+};
+
+class RangeDecoder {
+public:
+    RangeDecoder() = default;
+    RangeDecoder(const unsigned char* data, size_t size);
+
+    int decodeBit(uint16_t& probability);
+    uint32_t decodeBypass(int bitCount);
+
+    /**
+     * @return true if the decoder has read past the end of its input
+     */
+    bool overrun() const {
+        return position > size + 4;
+    }
+
+private:
+    unsigned char nextByte() {
+        return position < size ? data[position++] : (position++, 0);
+    }
+
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    size_t position = 0;
+    uint32_t range = 0xFFFFFFFF;
+    uint32_t code = 0;
+};
+
+/**
+ * CABAC-style context-adaptive binary arithmetic coder.
+ *
+ * Per block it codes a coded-block flag (context: coded flags of the left and upper block of the same type), the
+ * significance map and last-position flags (context: zig-zag position) and the coefficient levels in reverse scan
+ * order (context: number of levels equal to and greater than one coded so far). Luma and chroma keep separate
+ * contexts. Level remainders and signs are coded as bypass bits.
+ */
+class ArithmeticCoder : public EntropyCoder {
+public:
+    explicit ArithmeticCoder(int blocksPerRow): blocksPerRow{blocksPerRow} {
+        reset();
+    };
+
+    void encodeBlock(const Block& block) override;
+    std::vector<unsigned char> finish() override;
+
+    void startDecoding(const unsigned char* data, size_t size) override;
+    bool decodeBlock(BlockType type, std::vector<int>& zigZagValues) override;
+
+    class Contexts {
+    public:
+        uint16_t codedBlock[3];
+        uint16_t significant[63];
+        uint16_t last[63];
+        uint16_t greaterThanOne[5];
+        uint16_t levelPrefix[5];
+    };
+
+private:
+    static const int PREFIX_LIMIT = 14;
+
+    void reset();
+    int codedBlockContext(BlockType type) const;
+
+    void encodeExpGolomb(uint32_t value);
+    uint32_t decodeExpGolomb();
+
+    int blocksPerRow;
+
+    Contexts contexts[2];   // luma, chroma
+    std::vector<unsigned char> codedFlags[3];   // coded-block flag of every block so far, per type
+
+    RangeEncoder encoder;
+    RangeDecoder decoder;
+};
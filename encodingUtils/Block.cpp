@@ -2,10 +2,12 @@
 #include "Block.hpp"
 #include "DcCoefficient.hpp"
 #include "AcCoefficient.hpp"
+#include "EntropyDecoder.hpp"
 using namespace std;
 #define PI (double)EIGEN_PI
 
-int Block::END_OF_BLOCK = -2;
+// amplitude of the end of block symbol. AC values are never 0, zeroes are only counted in the run length
+int Block::END_OF_BLOCK = 0;
 
 Block* Block::expandTo8x8() const {
     auto* output = new Block{*this};
@@ -159,42 +161,57 @@ Block* Block::compressTo4x4() const {
     return output;
 }
 
+/**
+ * Bit i of the result is set if values[i] is not 0
+ * @param values The 64 zig-zag ordered values of a block
+ */
+uint64_t Block::nonZeroMask(const int* values) {
+    uint64_t mask = 0;
+
+#ifdef __SSE2__
+    // compare 4 values at a time against 0, movemask packs one bit per value
+    const __m128i zero = _mm_setzero_si128();
+    for(int i=0; i<64; i+=4) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        auto zeroBits = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(chunk, zero)));
+        mask |= static_cast<uint64_t>(~zeroBits & 0xF) << i;
+    }
+#else
+    for(int i=0; i<64; i++) {
+        mask |= static_cast<uint64_t>(values[i] != 0) << i;
+    }
+#endif
+
+    return mask;
+}
+
 std::vector<ACCoefficient> Block::entropy_encode() const {
     vector<ACCoefficient> output;
 
     vector<int> zigZagParsed = zigZagParse(*this);
 
-    // zigZagParsed ready
+    // zigZagParsed ready, find the non-zero AC values
+    uint64_t acMask = nonZeroMask(zigZagParsed.data()) & ~uint64_t{1};
+    output.reserve(__builtin_popcountll(acMask) + 2);
 
     // start building the output
     auto first = DCCoefficient(zigZagParsed[0]);
     // add the first value to the output as an AcCoef, even if it doesn't have a NoOfZeroes
     output.emplace_back(0, first);
 
-    int noOfZeroes = 0;
-    bool endingWithZero = false;
-    for(size_t i=1; i<zigZagParsed.size(); i++) {
-        auto val = zigZagParsed[i];
-        if(val == 0) {
-            // count the zeroes in front of the next non-zero value
-           noOfZeroes++;
-           endingWithZero = true;
-           continue;
-        }
-        else {
-            endingWithZero = false;
-
-            auto coef = ACCoefficient(noOfZeroes, DCCoefficient(val));
-            output.push_back(coef);
+    // every set bit is a non-zero value, the zeroes in front of it are the gap to the previous set bit
+    int previous = 0;
+    while(acMask) {
+        int i = __builtin_ctzll(acMask);
+        output.emplace_back(i - previous - 1, DCCoefficient(zigZagParsed[i]));
 
-            noOfZeroes = 0;
-        }
+        previous = i;
+        acMask &= acMask - 1;
     }
 
-    if(endingWithZero) {
+    if(previous < 63) {
         // in case the block ends with a 0
-        auto c = ACCoefficient(noOfZeroes, DCCoefficient(END_OF_BLOCK));
-        output.push_back(c);
+        output.emplace_back(63 - previous, DCCoefficient(END_OF_BLOCK));
     }
 
     return output;
@@ -204,40 +221,23 @@ std::vector<ACCoefficient> Block::entropy_encode() const {
  * Build a block from the list of coefficients.
  *
  * Strategy:
- * - get the list of (byte) coefficients from the list of AC coefficients
+ * - decode a single block with an EntropyDecoder viewing the list from last_idx on
+ * - for repeated decoding of a whole stream, use an EntropyDecoder directly
  * @param coefList
  * @param last_idx The index of the last processed coef. from the coef list
- * @return
+ * @return The block, nullptr if the list does not hold a complete, valid block from last_idx on
  */
-Block* Block::entropy_decode(std::vector<ACCoefficient> coefList, int& last_idx) {
+Block* Block::entropy_decode(const std::vector<ACCoefficient>& coefList, int& last_idx) {
+    EntropyDecoder decoder{coefList.data() + last_idx, coefList.size() - last_idx};
 
-    DCCoefficient dcCoefficient = coefList[last_idx++].dcCoefficient;
     vector<int> pixelValues;
-
-    // add the first value (dcCoef)
-    pixelValues.push_back(dcCoefficient.amplitude);
-    // for the AC Coefs. : place <runLength> zeroes THEN place the value
-
-    while(pixelValues.size() < 64) {
-        auto acCoef = coefList[last_idx++];
-        int zeroesBefore = acCoef.runlength;
-        int value = acCoef.dcCoefficient.amplitude;
-
-        // place the zeroes
-        while(zeroesBefore) {
-            pixelValues.push_back(0);
-            zeroesBefore--;
-        }
-
-        if(value != END_OF_BLOCK) {
-            // place the non-zero amplitude that follows the 0s
-            pixelValues.push_back(value);
-        }
+    Matrix<int, Dynamic, Dynamic> blockMatrix;
+    if(not decoder.decodeNext(blockMatrix, pixelValues)) {
+        // truncated or corrupt list, last_idx stays on the block
+        return nullptr;
     }
 
-    assert(pixelValues.size() == 64);
-    // build a block matrix from the byte vector (zig-zag parsing in reverse)
-    auto blockMatrix = zigZagReverse(pixelValues);
+    last_idx += static_cast<int>(decoder.position());
 
     // build a block from the block matrix
     auto block = new Block(blockMatrix);
@@ -1,5 +1,9 @@
 #pragma once
+#include <cstdint>
 #include <utility>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "../Eigen/Dense"
 #include "../Eigen/src/Core/util/Constants.h"
@@ -47,6 +51,8 @@ public:
         Q = toMove.Q;
     };
 
+    static int END_OF_BLOCK;
+
     Matrix<int, Dynamic, Dynamic> values;
     BlockType type;
     std::tuple<std::pair<int, int>, std::pair<int, int>, std::pair<int, int>, std::pair<int, int>> location;
@@ -73,13 +79,14 @@ public:
      * @param i The index of the block in the final image
      */
     void computeLocation(const int& i);
-    static Block* entropy_decode(std::vector<ACCoefficient> coefList, int& last_idx);
+    static Block* entropy_decode(const std::vector<ACCoefficient>& coefList, int& last_idx);
     static std::vector<int> zigZagParse(const Block& block);
     static Matrix<int, Dynamic, Dynamic> zigZagReverse(const std::vector<int>& zigZagParsed);
 
 private:
     Matrix<int, Dynamic, Dynamic> Q;
-    static int END_OF_BLOCK;
+
+    static uint64_t nonZeroMask(const int* values);
 
     [[nodiscard]] float alpha(const int& u) const;
     [[nodiscard]] float sumFDCT(const int& u, const int& v) const;
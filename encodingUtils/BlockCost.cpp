@@ -0,0 +1,180 @@
+#include <cstdlib>
+#include "BlockCost.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+    /**
+     * 8 point Hadamard butterflies over v[0], v[stride], ..., v[7 * stride]
+     * Produces the Hadamard coefficients in a permuted order, which does not change their absolute sum
+     */
+    void hadamard8(int* v, int stride) {
+        for(int step=4; step>=1; step/=2) {
+            for(int i=0; i<8; i++) {
+                if(i & step) {
+                    continue;
+                }
+                int a = v[i * stride], b = v[(i + step) * stride];
+                v[i * stride] = a + b;
+                v[(i + step) * stride] = a - b;
+            }
+        }
+    }
+
+    int satd8x8Scalar(const unsigned char* a, int aStride, const unsigned char* b, int bStride) {
+        int diff[64];
+        for(int i=0; i<8; i++) {
+            for(int j=0; j<8; j++) {
+                diff[8 * i + j] = a[i * aStride + j] - b[i * bStride + j];
+            }
+        }
+
+        for(int i=0; i<8; i++) {
+            hadamard8(diff + 8 * i, 1);     // rows
+        }
+        for(int j=0; j<8; j++) {
+            hadamard8(diff + j, 8);         // columns
+        }
+
+        int sum = 0;
+        for(int value : diff) {
+            sum += abs(value);
+        }
+        return (sum + 2) >> 2;
+    }
+
+#ifdef __SSE2__
+    int horizontalSum(__m128i v) {
+        v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+        v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtsi128_si32(v);
+    }
+
+    // butterflies between registers, the same network as hadamard8
+    void hadamard8(__m128i* r) {
+        for(int step=4; step>=1; step/=2) {
+            for(int i=0; i<8; i++) {
+                if(i & step) {
+                    continue;
+                }
+                __m128i a = r[i], b = r[i + step];
+                r[i] = _mm_add_epi16(a, b);
+                r[i + step] = _mm_sub_epi16(a, b);
+            }
+        }
+    }
+
+    void transpose8x8(__m128i* r) {
+        __m128i a0 = _mm_unpacklo_epi16(r[0], r[1]), a1 = _mm_unpackhi_epi16(r[0], r[1]);
+        __m128i a2 = _mm_unpacklo_epi16(r[2], r[3]), a3 = _mm_unpackhi_epi16(r[2], r[3]);
+        __m128i a4 = _mm_unpacklo_epi16(r[4], r[5]), a5 = _mm_unpackhi_epi16(r[4], r[5]);
+        __m128i a6 = _mm_unpacklo_epi16(r[6], r[7]), a7 = _mm_unpackhi_epi16(r[6], r[7]);
+
+        __m128i b0 = _mm_unpacklo_epi32(a0, a2), b1 = _mm_unpackhi_epi32(a0, a2);
+        __m128i b2 = _mm_unpacklo_epi32(a1, a3), b3 = _mm_unpackhi_epi32(a1, a3);
+        __m128i b4 = _mm_unpacklo_epi32(a4, a6), b5 = _mm_unpackhi_epi32(a4, a6);
+        __m128i b6 = _mm_unpacklo_epi32(a5, a7), b7 = _mm_unpackhi_epi32(a5, a7);
+
+        r[0] = _mm_unpacklo_epi64(b0, b4), r[1] = _mm_unpackhi_epi64(b0, b4);
+        r[2] = _mm_unpacklo_epi64(b1, b5), r[3] = _mm_unpackhi_epi64(b1, b5);
+        r[4] = _mm_unpacklo_epi64(b2, b6), r[5] = _mm_unpackhi_epi64(b2, b6);
+        r[6] = _mm_unpacklo_epi64(b3, b7), r[7] = _mm_unpackhi_epi64(b3, b7);
+    }
+
+    int satd8x8Sse2(const unsigned char* a, int aStride, const unsigned char* b, int bStride) {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i r[8];
+
+        // one row of 16 bit differences per register. Differences fit 9 bits, after both passes they fit 15 bits
+        for(int i=0; i<8; i++) {
+            __m128i rowA = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + i * aStride)), zero);
+            __m128i rowB = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(b + i * bStride)), zero);
+            r[i] = _mm_sub_epi16(rowA, rowB);
+        }
+
+        hadamard8(r);       // columns
+        transpose8x8(r);
+        hadamard8(r);       // rows
+
+        const __m128i ones = _mm_set1_epi16(1);
+        __m128i sum = zero;
+        for(auto& v : r) {
+            __m128i absolute = _mm_max_epi16(v, _mm_sub_epi16(zero, v));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(absolute, ones));
+        }
+        return (horizontalSum(sum) + 2) >> 2;
+    }
+#endif
+}
+
+int BlockCost::sadScalar(const unsigned char* a, int aStride, const unsigned char* b, int bStride, int size) {
+    int sum = 0;
+    for(int i=0; i<size; i++) {
+        for(int j=0; j<size; j++) {
+            sum += abs(a[j] - b[j]);
+        }
+        a += aStride;
+        b += bStride;
+    }
+    return sum;
+}
+
+int BlockCost::satdScalar(const unsigned char* a, int aStride, const unsigned char* b, int bStride, int size) {
+    int sum = 0;
+    for(int i=0; i<size; i+=8) {
+        for(int j=0; j<size; j+=8) {
+            sum += satd8x8Scalar(a + i * aStride + j, aStride, b + i * bStride + j, bStride);
+        }
+    }
+    return sum;
+}
+
+int BlockCost::sad8x8(const unsigned char* a, int aStride, const unsigned char* b, int bStride) {
+#ifdef __SSE2__
+    // psadbw over two rows at a time, each half of the result holds the sum of one row
+    __m128i sum = _mm_setzero_si128();
+    for(int i=0; i<8; i+=2) {
+        __m128i rowsA = _mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + i * aStride)),
+                                           _mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + (i + 1) * aStride)));
+        __m128i rowsB = _mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(b + i * bStride)),
+                                           _mm_loadl_epi64(reinterpret_cast<const __m128i*>(b + (i + 1) * bStride)));
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(rowsA, rowsB));
+    }
+    return _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+#else
+    return sadScalar(a, aStride, b, bStride, 8);
+#endif
+}
+
+int BlockCost::sad16x16(const unsigned char* a, int aStride, const unsigned char* b, int bStride) {
+#ifdef __SSE2__
+    __m128i sum = _mm_setzero_si128();
+    for(int i=0; i<16; i++) {
+        __m128i rowA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i * aStride));
+        __m128i rowB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i * bStride));
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(rowA, rowB));
+    }
+    return _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+#else
+    return sadScalar(a, aStride, b, bStride, 16);
+#endif
+}
+
+int BlockCost::satd8x8(const unsigned char* a, int aStride, const unsigned char* b, int bStride) {
+#ifdef __SSE2__
+    return satd8x8Sse2(a, aStride, b, bStride);
+#else
+    return satd8x8Scalar(a, aStride, b, bStride);
+#endif
+}
+
+int BlockCost::satd16x16(const unsigned char* a, int aStride, const unsigned char* b, int bStride) {
+    return satd8x8(a, aStride, b, bStride)
+         + satd8x8(a + 8, aStride, b + 8, bStride)
+         + satd8x8(a + 8 * aStride, aStride, b + 8 * bStride, bStride)
+         + satd8x8(a + 8 * aStride + 8, aStride, b + 8 * bStride + 8, bStride);
+}
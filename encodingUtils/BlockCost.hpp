@@ -0,0 +1,21 @@
+#pragma once
+
+/**
+ * Block difference costs for motion search, over 8 bit samples addressed by a pointer to the top left sample and
+ * a row stride.
+ *
+ * SAD: sum of absolute differences
+ * SATD: sum of absolute 8x8 Hadamard transformed differences, divided by 4. 16x16 blocks sum their four 8x8 parts.
+ *
+ * The plain functions use SSE2 when it is available, the *Scalar functions are the reference implementations.
+ */
+class BlockCost {
+public:
+    static int sad8x8(const unsigned char* a, int aStride, const unsigned char* b, int bStride);
+    static int sad16x16(const unsigned char* a, int aStride, const unsigned char* b, int bStride);
+    static int satd8x8(const unsigned char* a, int aStride, const unsigned char* b, int bStride);
+    static int satd16x16(const unsigned char* a, int aStride, const unsigned char* b, int bStride);
+
+    static int sadScalar(const unsigned char* a, int aStride, const unsigned char* b, int bStride, int size);
+    static int satdScalar(const unsigned char* a, int aStride, const unsigned char* b, int bStride, int size);
+};
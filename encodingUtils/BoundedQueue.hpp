@@ -0,0 +1,71 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+/**
+ * A first in, first out queue between threads holding at most capacity items.
+ *
+ * push() blocks while the queue is full, so a fast producer waits for its consumer instead of piling up items.
+ * After close() the items left can still be popped, then pop() reports the end.
+ */
+template<class T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(std::size_t capacity): capacity{capacity} {};
+
+    /**
+     * Append an item, waiting for a free place
+     * @return false if the queue was closed, the item is dropped
+     */
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock{mutex};
+        notFull.wait(lock, [this]() {
+            return closed || items.size() < capacity;
+        });
+        if(closed) {
+            return false;
+        }
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    /**
+     * Take the oldest item, waiting for one
+     * @return false if the queue is closed and empty
+     */
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock{mutex};
+        notEmpty.wait(lock, [this]() {
+            return closed || not items.empty();
+        });
+        if(items.empty()) {
+            return false;
+        }
+        item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    /**
+     * End the queue, waking every waiting thread
+     */
+    void close() {
+        std::lock_guard<std::mutex> lock{mutex};
+        closed = true;
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+
+private:
+    std::size_t capacity;
+    std::deque<T> items;
+    bool closed = false;
+
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+};
@@ -0,0 +1,84 @@
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include "CoefficientDump.hpp"
+
+using namespace std;
+
+namespace {
+    void writeInt32(ofstream& stream, int32_t value) {
+        unsigned char bytes[4] = {static_cast<unsigned char>(value), static_cast<unsigned char>(value >> 8),
+                                  static_cast<unsigned char>(value >> 16), static_cast<unsigned char>(value >> 24)};
+        stream.write(reinterpret_cast<const char*>(bytes), 4);
+    }
+
+    int32_t readInt32(ifstream& stream) {
+        unsigned char bytes[4] = {0, 0, 0, 0};
+        stream.read(reinterpret_cast<char*>(bytes), 4);
+        return static_cast<int32_t>(bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24));
+    }
+}
+
+CoefficientDump CoefficientDump::record(const tuple<vector<Block>, vector<Block>, vector<Block>>& blocks,
+                                        int blocksPerRow) {
+    CoefficientDump dump;
+    dump.blocksPerRow = blocksPerRow;
+
+    for(size_t i=0; i<get<0>(blocks).size(); i++) {
+        const Block* sources[3] = {&get<0>(blocks)[i], &get<1>(blocks)[i], &get<2>(blocks)[i]};
+        for(auto source : sources) {
+            auto expanded = source->expandTo8x8();
+            dump.types.push_back(source->type);
+            dump.zigZagValues.push_back(Block::zigZagParse(*expanded));
+            delete expanded;
+        }
+    }
+
+    return dump;
+}
+
+void CoefficientDump::write(const std::string& filename) const {
+    ofstream stream(filename, ios::binary);
+
+    writeInt32(stream, static_cast<int32_t>(types.size()));
+    writeInt32(stream, blocksPerRow);
+
+    for(size_t i=0; i<types.size(); i++) {
+        stream.put(static_cast<char>(types[i]));
+        for(auto value : zigZagValues[i]) {
+            auto v = static_cast<uint16_t>(value);
+            stream.put(static_cast<char>(v & 0xFF));
+            stream.put(static_cast<char>(v >> 8));
+        }
+    }
+}
+
+CoefficientDump CoefficientDump::read(const std::string& filename) {
+    ifstream stream(filename, ios::binary);
+    if(not stream) {
+        throw runtime_error("cannot open coefficient dump " + filename);
+    }
+
+    CoefficientDump dump;
+    auto count = readInt32(stream);
+    dump.blocksPerRow = readInt32(stream);
+
+    unsigned char bytes[128];
+    for(int32_t i=0; i<count; i++) {
+        auto type = stream.get();
+        stream.read(reinterpret_cast<char*>(bytes), sizeof(bytes));
+        if(not stream) {
+            throw runtime_error("truncated coefficient dump " + filename);
+        }
+
+        vector<int> values(64);
+        for(int j=0; j<64; j++) {
+            values[j] = static_cast<int16_t>(bytes[2 * j] | (bytes[2 * j + 1] << 8));
+        }
+
+        dump.types.push_back(static_cast<BlockType>(type));
+        dump.zigZagValues.push_back(move(values));
+    }
+
+    return dump;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "Block.hpp"
+
+/**
+ * Recorded input of the entropy stage: the 8x8 blocks of a frame, as fed to Block::entropy_encode.
+ *
+ * File layout (little endian): int32 block count, int32 blocks per row, then per block one type byte followed by
+ * the 64 values in zig-zag order as int16.
+ */
+class CoefficientDump {
+public:
+    int blocksPerRow = 0;
+    std::vector<BlockType> types;
+    std::vector<std::vector<int>> zigZagValues;
+
+    /**
+     * Record the interleaved Y, Cb, Cr blocks of a frame
+     * @param blocks The Y, U and V blocks of the frame, U and V still 4x4
+     * @param blocksPerRow The number of blocks in a block row of the frame
+     */
+    static CoefficientDump record(const std::tuple<std::vector<Block>, std::vector<Block>, std::vector<Block>>& blocks,
+                                  int blocksPerRow);
+
+    void write(const std::string& filename) const;
+    static CoefficientDump read(const std::string& filename);
+};
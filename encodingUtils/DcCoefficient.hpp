@@ -1,12 +1,19 @@
 #pragma once
 
 #include <cmath>
+#include <stdexcept>
+#include <string>
 
 class DCCoefficient {
 public:
     explicit DCCoefficient(int value): size{DCCoefficient::getScale(static_cast<int>(value))}, amplitude{value} {};
     int size;
     int amplitude;
+
+    /**
+     * The largest magnitude whose scale fits the 9 size classes
+     */
+    static constexpr int MAX_AMPLITUDE = 511;
 private:
     static int getScale(int value) {
         if(value == 0) {
@@ -18,6 +25,6 @@ private:
                 return i;
             }
         }
-        assert(false);
+        throw std::out_of_range("amplitude " + std::to_string(value) + " is out of the DC coefficient range");
     }
 };
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+
+#include "AcCoefficient.hpp"
+#include "MotionVector.hpp"
+
+/**
+ * I_FRAME: every block is coded on its own
+ * P_FRAME: every block is predicted from the previous I or P frame and only the difference is coded
+ * B_FRAME: every block is predicted from the I or P frames before and after it in display order. B frames are
+ *          never used as a reference, they follow the later of their two references in decode order.
+ */
+enum FrameType {I_FRAME, P_FRAME, B_FRAME};
+
+/**
+ * Reference a B frame block is predicted from
+ * FORWARD: the earlier reference, BACKWARD: the later reference, BIDIRECTIONAL: the average of both
+ */
+enum PredictionDirection {FORWARD, BACKWARD, BIDIRECTIONAL};
+
+/**
+ * The compressed form of a frame.
+ *
+ * For every 8x8 luma block, in raster order, the coefficients hold the residual Y block followed by the residual
+ * Cb and Cr blocks, expanded to 8x8. P frames carry one skip flag per block. Skipped blocks are copied from the
+ * co-located reference block and have neither a motion vector nor coefficients. Every other block of a P frame
+ * has a motion vector in quarter luma samples, chroma uses the vector halved in quarter chroma samples.
+ *
+ * B frames also carry one skip flag per block, skipped blocks are copied from the earlier reference. Every other
+ * block has a prediction direction, a vector in motionVectors if it uses the earlier reference and a vector in
+ * backwardVectors if it uses the later one.
+ *
+ * Residuals are coded divided by the quantizer of their block row, which is the frame quantizer unless the rate
+ * control set one per row. A quantizer of 1 is lossless.
+ */
+class EncodedFrame {
+public:
+    FrameType type = I_FRAME;
+    int frameNumber = 0;    // position of the frame in display order
+    int width = 0;
+    int height = 0;
+
+    int quantizer = 1;
+    std::vector<int> rowQuantizers;     // one per block row, empty if every row uses quantizer
+
+    std::vector<bool> skipFlags;
+    std::vector<MotionVector> motionVectors;
+    std::vector<PredictionDirection> directions;
+    std::vector<MotionVector> backwardVectors;
+    std::vector<ACCoefficient> coefficients;
+
+    /**
+     * @return The quantizer of the blocks in a block row
+     */
+    int quantizerOfRow(int row) const {
+        return rowQuantizers.empty() ? quantizer : rowQuantizers[row];
+    }
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <set>
+
+/**
+ * FULL_SEARCH: every candidate of the search window
+ * DIAMOND_SEARCH: large diamond steps until the centre is best, then one small diamond step
+ * HEXAGON_SEARCH: hexagon steps until the centre is best, then one small diamond step
+ * PYRAMID_SEARCH: full search on half resolution planes, refined with small diamond steps at full resolution
+ */
+enum SearchStrategy {FULL_SEARCH, DIAMOND_SEARCH, HEXAGON_SEARCH, PYRAMID_SEARCH};
+
+/**
+ * CONSTANT_QUALITY: every frame uses the same quantizer
+ * CONSTANT_BITRATE: every frame gets about the same share of the bitrate, the VBV buffer is kept half full
+ * AVERAGE_BITRATE: frames get more or fewer bits with their complexity, the average over about a second meets the
+ *                  bitrate and no frame underflows the VBV buffer
+ */
+enum RateControlMode {CONSTANT_QUALITY, CONSTANT_BITRATE, AVERAGE_BITRATE};
+
+/**
+ * Settings of a VideoEncoder
+ */
+class EncoderSettings {
+public:
+    // motion search
+    int searchRange = 16;
+    SearchStrategy searchStrategy = DIAMOND_SEARCH;
+    int earlyTermination = 64;  // stop searching once a candidate's SAD is at most this, 0 disables it
+    int subpelRefinement = 2;   // 0: integer vectors, 1: refined to half samples, 2: refined to quarter samples
+
+    // skip blocks: P frame blocks whose co-located reference block has a luma SAD of at most skipThreshold, and a
+    // SAD of at most skipThreshold / 4 in each chroma block, are copied from the reference. Both thresholds are
+    // multiplied by the quantizer of the block row. Negative disables them.
+    int skipThreshold = 32;
+
+    // GOP structure: an I frame starts a group of pictures every keyframeInterval frames and at every frame number
+    // in forcedKeyframes. A closed GOP never references frames of the previous GOP. In an open GOP the B frames
+    // right before a keyframe are predicted from both the previous GOP and the keyframe.
+    int keyframeInterval = 30;
+    bool closedGop = true;
+    std::set<int> forcedKeyframes;
+
+    // scene cuts: a frame whose 8x8 block luma averages differ from the previous frame's by sceneCutThreshold on
+    // average is coded as an I frame and starts a new GOP. Negative disables the detection.
+    int sceneCutThreshold = 24;
+
+    // B frames: up to bFrames consecutive frames are coded as B frames. The encoder holds up to lookahead frames
+    // (at least bFrames + 1) before coding them, which bounds its memory use.
+    int bFrames = 0;
+    int lookahead = 1;
+
+    // rate control: residuals are divided by a quantizer, 1 is lossless. The bitrate modes choose it per frame
+    // between minQuantizer and maxQuantizer to reach targetBitrate bits per second at frameRate frames per second,
+    // and per block row as well with rowRateControl. The VBV buffer holds vbvBufferSize bits, 0 means one second.
+    RateControlMode rateControl = CONSTANT_QUALITY;
+    int quantizer = 1;
+    int minQuantizer = 1;
+    int maxQuantizer = 31;
+    int targetBitrate = 0;
+    int frameRate = 30;
+    int vbvBufferSize = 0;
+    bool rowRateControl = false;
+
+    // threads: block rows are coded at the same time as a wavefront, each row two blocks behind the one above it so
+    // that the vectors of its upper neighbours are known. The output does not depend on the number of threads.
+    // Row rate control needs the bits of every row above, it codes the rows one after the other.
+    unsigned threads = 1;
+
+    // real time: the encoder times every frame against the frame interval of frameRate. While it falls behind it
+    // moves to cheaper motion search, B frame and quantizer settings, one speed level at a time, and back once it
+    // has headroom again, see SpeedController. The output then depends on the speed of the machine.
+    bool realTime = false;
+};
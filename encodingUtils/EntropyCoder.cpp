@@ -0,0 +1,68 @@
+#include <stdexcept>
+#include "EntropyCoder.hpp"
+#include "RunLengthCoder.hpp"
+#include "ArithmeticCoder.hpp"
+
+using namespace std;
+
+unique_ptr<EntropyCoder> EntropyCoder::create(EntropyMode mode, int blocksPerRow) {
+    switch(mode) {
+        case ARITHMETIC:
+            return make_unique<ArithmeticCoder>(blocksPerRow);
+        case RUN_LENGTH:
+        default:
+            return make_unique<RunLengthCoder>();
+    }
+}
+
+CodedFrame EntropyCoder::encodeFrame(const tuple<vector<Block>, vector<Block>, vector<Block>>& blocks,
+                                     int blocksPerRow, EntropyMode mode) {
+    auto coder = create(mode, blocksPerRow);
+
+    CodedFrame output;
+    output.mode = mode;
+    output.blocksPerRow = blocksPerRow;
+    output.blockCount = static_cast<int>(get<0>(blocks).size());
+
+    for(int i=0; i<output.blockCount; i++) {
+        const Block* sources[3] = {&get<0>(blocks)[i], &get<1>(blocks)[i], &get<2>(blocks)[i]};
+        for(auto source : sources) {
+            // skip the DCT part, expand to 8x8
+            auto expanded = source->expandTo8x8();
+            coder->encodeBlock(*expanded);
+            delete expanded;
+        }
+    }
+
+    output.bytes = coder->finish();
+    return output;
+}
+
+tuple<vector<Block*>, vector<Block*>, vector<Block*>> EntropyCoder::decodeFrame(const CodedFrame& frame) {
+    auto coder = create(frame.mode, frame.blocksPerRow);
+    coder->startDecoding(frame.bytes.data(), frame.bytes.size());
+
+    vector<Block*> Y, U, V;
+    vector<Block*>* outputs[3] = {&Y, &U, &V};
+    const BlockType types[3] = {BlockType::Y, BlockType::U, BlockType::V};
+    vector<int> zigZagValues;
+
+    for(int i=0; i<frame.blockCount; i++) {
+        for(int c=0; c<3; c++) {
+            if(not coder->decodeBlock(types[c], zigZagValues)) {
+                for(auto output : outputs) {
+                    for(auto block : *output) {
+                        delete block;
+                    }
+                }
+                throw runtime_error("truncated or corrupt frame at block " + to_string(i));
+            }
+
+            auto block = new Block(Block::zigZagReverse(zigZagValues));
+            block->setType(types[c]);
+            outputs[c]->push_back(block);
+        }
+    }
+
+    return make_tuple(Y, U, V);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include "Block.hpp"
+
+/**
+ * The entropy coding scheme of a stream
+ * RUN_LENGTH: the (run length, amplitude) pairs of Block::entropy_encode
+ * ARITHMETIC: context-adaptive binary arithmetic coding, for the highest compression presets
+ */
+enum EntropyMode {RUN_LENGTH, ARITHMETIC};
+
+/**
+ * The entropy coded bytes of a frame, tagged with the mode that produced them
+ */
+class CodedFrame {
+public:
+    EntropyMode mode = RUN_LENGTH;
+    int blocksPerRow = 0;
+    int blockCount = 0;
+    std::vector<unsigned char> bytes;
+};
+
+/**
+ * Common interface of the entropy coders.
+ *
+ * A coder either encodes blocks in frame order until finish() is called, or decodes them in the same order after
+ * startDecoding(). Blocks of each type (Y, U, V) form their own sequence in frame order, which adaptive coders use
+ * to look up the neighbouring blocks.
+ */
+class EntropyCoder {
+public:
+    virtual ~EntropyCoder() = default;
+
+    /**
+     * Encode the values of an 8x8 block
+     * @param block The block, U and V blocks already expanded to 8x8
+     */
+    virtual void encodeBlock(const Block& block) = 0;
+
+    /**
+     * End the current frame
+     * @return The bytes of every block encoded since the previous call
+     */
+    virtual std::vector<unsigned char> finish() = 0;
+
+    /**
+     * Start decoding a frame
+     * @param data The bytes produced by finish(). Must stay alive while decoding.
+     * @param size The number of bytes
+     */
+    virtual void startDecoding(const unsigned char* data, size_t size) = 0;
+
+    /**
+     * Decode the next block of the given type
+     * @param type The type of the block, blocks must be requested in the order they were encoded
+     * @param zigZagValues Output storage for the 64 zig-zag ordered values
+     * @return false if the input does not hold another valid block
+     */
+    virtual bool decodeBlock(BlockType type, std::vector<int>& zigZagValues) = 0;
+
+    /**
+     * Create the coder of a stream
+     * @param mode The entropy mode of the stream
+     * @param blocksPerRow The number of blocks in a block row, used for the neighbour contexts
+     */
+    static std::unique_ptr<EntropyCoder> create(EntropyMode mode, int blocksPerRow);
+
+    /**
+     * Entropy-code the interleaved Y, Cb, Cr blocks of a frame
+     * @param blocks The Y, U and V blocks of the frame, U and V still 4x4
+     * @param blocksPerRow The number of blocks in a block row of the frame
+     * @param mode The entropy mode of the stream
+     */
+    static CodedFrame encodeFrame(const std::tuple<std::vector<Block>, std::vector<Block>, std::vector<Block>>& blocks,
+                                  int blocksPerRow, EntropyMode mode);
+
+    /**
+     * Decode a frame produced by encodeFrame
+     * @return The 8x8 Y, Cb and Cr blocks in frame order, with their types set
+     * @throw runtime_error if the bytes do not hold blockCount valid blocks
+     */
+    static std::tuple<std::vector<Block*>, std::vector<Block*>, std::vector<Block*>> decodeFrame(const CodedFrame& frame);
+};
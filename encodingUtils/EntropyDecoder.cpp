@@ -0,0 +1,75 @@
+#include "EntropyDecoder.hpp"
+#include "Block.hpp"
+
+using namespace std;
+
+void EntropyDecoder::feed(const ACCoefficient* coefficients, size_t count) {
+    if(data != buffer.data()) {
+        // still viewing the caller's memory, take over the unread part
+        buffer.assign(data + cursor, data + size);
+        cursor = 0;
+    }
+    else if(cursor > buffer.size() / 2) {
+        // drop the consumed prefix so the buffer does not grow with the whole stream
+        buffer.erase(buffer.begin(), buffer.begin() + cursor);
+        cursor = 0;
+    }
+
+    buffer.insert(buffer.end(), coefficients, coefficients + count);
+    data = buffer.data();
+    size = buffer.size();
+}
+
+bool EntropyDecoder::decodeNext(std::vector<int>& zigZagValues) {
+    zigZagValues.resize(64);
+
+    size_t idx = cursor;
+    if(corruptInput || idx >= size) {
+        return false;
+    }
+
+    // the first value is the DC coefficient
+    zigZagValues[0] = data[idx++].dcCoefficient.amplitude;
+    size_t filled = 1;
+
+    // for the AC Coefs. : place <runLength> zeroes THEN place the value
+    while(filled < 64) {
+        if(idx >= size) {
+            // the rest of the block has not arrived yet
+            return false;
+        }
+
+        const auto& acCoef = data[idx++];
+        int zeroesBefore = acCoef.runlength;
+        int value = acCoef.dcCoefficient.amplitude;
+
+        size_t needed = static_cast<size_t>(zeroesBefore) + (value != Block::END_OF_BLOCK ? 1 : 0);
+        if(zeroesBefore < 0 || filled + needed > 64) {
+            // a marker or a damaged run, the block would overflow
+            corruptInput = true;
+            return false;
+        }
+        while(zeroesBefore) {
+            zigZagValues[filled++] = 0;
+            zeroesBefore--;
+        }
+
+        if(value != Block::END_OF_BLOCK) {
+            // place the non-zero amplitude that follows the 0s
+            zigZagValues[filled++] = value;
+        }
+    }
+
+    consumed += idx - cursor;
+    cursor = idx;
+    return true;
+}
+
+bool EntropyDecoder::decodeNext(Matrix<int, Dynamic, Dynamic>& blockValues, std::vector<int>& zigZagValues) {
+    if(not decodeNext(zigZagValues)) {
+        return false;
+    }
+
+    blockValues = Block::zigZagReverse(zigZagValues);
+    return true;
+}
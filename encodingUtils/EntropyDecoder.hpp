@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+
+#include "../Eigen/Dense"
+#include "AcCoefficient.hpp"
+
+using Eigen::Matrix;
+using Eigen::Dynamic;
+
+/**
+ * Streaming decoder over a list of AC coefficients.
+ *
+ * The decoder keeps its own read position, so blocks are decoded one after another without copying the stream.
+ * It either views memory owned by the caller or, once feed() has been called, an internal buffer that grows as
+ * more coefficients arrive. A block is only consumed when all of its coefficients are available.
+ */
+class EntropyDecoder {
+public:
+    EntropyDecoder() = default;
+    EntropyDecoder(const ACCoefficient* coefficients, size_t count): data{coefficients}, size{count} {};
+    explicit EntropyDecoder(const std::vector<ACCoefficient>& coefficients):
+            data{coefficients.data()}, size{coefficients.size()} {};
+
+    /**
+     * Append coefficients to the stream, e.g. as parts of a packet arrive
+     * @param coefficients The new coefficients
+     * @param count The number of new coefficients
+     */
+    void feed(const ACCoefficient* coefficients, size_t count);
+
+    /**
+     * Decode the next block into the 64 zig-zag ordered values
+     * @param zigZagValues Output storage, resized to 64
+     * @return false if the remaining input does not hold a complete block or is corrupt, see corrupt().
+     * Nothing is consumed in that case.
+     */
+    bool decodeNext(std::vector<int>& zigZagValues);
+
+    /**
+     * Decode the next block into an 8x8 matrix
+     * @param blockValues Output storage, resized to 8x8
+     * @param zigZagValues Scratch storage for the zig-zag ordered values
+     * @return false if the remaining input does not hold a complete block or is corrupt
+     */
+    bool decodeNext(Matrix<int, Dynamic, Dynamic>& blockValues, std::vector<int>& zigZagValues);
+
+    /**
+     * @return The number of coefficients consumed so far
+     */
+    size_t position() const {
+        return consumed;
+    }
+
+    /**
+     * @return true if every coefficient fed so far has been consumed
+     */
+    bool exhausted() const {
+        return cursor == size;
+    }
+
+    /**
+     * @return true if a block had a negative run or more than 64 values. Every later decodeNext() fails.
+     */
+    bool corrupt() const {
+        return corruptInput;
+    }
+
+private:
+    const ACCoefficient* data = nullptr;
+    size_t size = 0;
+    size_t cursor = 0;      // read position in data
+    size_t consumed = 0;    // read position in the whole stream, survives buffer compaction
+    bool corruptInput = false;
+
+    std::vector<ACCoefficient> buffer;
+};
@@ -0,0 +1,102 @@
+#include <cstring>
+#include <utility>
+#include "Frame.hpp"
+
+using namespace std;
+
+namespace {
+    int alignUp(int value) {
+        return (value + Plane::ALIGNMENT - 1) / Plane::ALIGNMENT * Plane::ALIGNMENT;
+    }
+}
+
+Plane::Plane(int width, int height, int padding): width{width}, height{height}, padding{padding} {
+    // the left border is rounded up so that column 0 of every row is aligned
+    int leftBorder = alignUp(padding);
+    stride = alignUp(leftBorder + width + padding);
+    data.reset(static_cast<unsigned char*>(aligned_alloc(ALIGNMENT, max<size_t>(ALIGNMENT, bufferSize()))));
+    memset(data.get(), 0, bufferSize());
+    origin = data.get() + static_cast<ptrdiff_t>(padding) * stride + leftBorder;
+}
+
+Plane::Plane(const Plane& other): Plane{other.width, other.height, other.padding} {
+    if(bufferSize() != 0) {
+        memcpy(data.get(), other.data.get(), bufferSize());
+    }
+}
+
+Plane& Plane::operator=(const Plane& other) {
+    if(this == &other) {
+        return *this;
+    }
+    if(width != other.width || height != other.height || padding != other.padding || not data) {
+        Plane copy{other};
+        swap(copy);
+        return *this;
+    }
+    memcpy(data.get(), other.data.get(), bufferSize());
+    return *this;
+}
+
+void Plane::swap(Plane& other) noexcept {
+    std::swap(width, other.width);
+    std::swap(height, other.height);
+    std::swap(padding, other.padding);
+    std::swap(stride, other.stride);
+    std::swap(data, other.data);
+    std::swap(origin, other.origin);
+}
+
+void Plane::extendBorders() {
+    if(padding == 0) {
+        return;
+    }
+    for(int r=0; r<height; r++) {
+        auto samples = row(r);
+        memset(samples - padding, samples[0], padding);
+        memset(samples + width, samples[width - 1], padding);
+    }
+    for(int r=1; r<=padding; r++) {
+        memcpy(row(-r) - padding, row(0) - padding, width + 2 * padding);
+        memcpy(row(height - 1 + r) - padding, row(height - 1) - padding, width + 2 * padding);
+    }
+}
+
+Frame Frame::fromImage(Image& image) {
+    auto yCbCr = image.getYCbCrImage();
+    Frame frame{static_cast<int>(yCbCr.cols()), static_cast<int>(yCbCr.rows())};
+
+    for(int i=0; i<frame.height(); i++) {
+        auto yRow = frame.y.row(i);
+        for(int j=0; j<frame.width(); j++) {
+            yRow[j] = yCbCr(i, j).Y;
+        }
+    }
+
+    // average each 2x2 region to a single chroma value
+    for(int i=0; i<frame.cb.height; i++) {
+        for(int j=0; j<frame.cb.width; j++) {
+            int sumCb = yCbCr(2 * i, 2 * j).Cb + yCbCr(2 * i, 2 * j + 1).Cb
+                      + yCbCr(2 * i + 1, 2 * j).Cb + yCbCr(2 * i + 1, 2 * j + 1).Cb;
+            int sumCr = yCbCr(2 * i, 2 * j).Cr + yCbCr(2 * i, 2 * j + 1).Cr
+                      + yCbCr(2 * i + 1, 2 * j).Cr + yCbCr(2 * i + 1, 2 * j + 1).Cr;
+            frame.cb(i, j) = static_cast<unsigned char>(sumCb / 4);
+            frame.cr(i, j) = static_cast<unsigned char>(sumCr / 4);
+        }
+    }
+
+    return frame;
+}
+
+Image Frame::toImage() const {
+    Matrix<YCbCrPixel, Dynamic, Dynamic> imageMatrix;
+    imageMatrix.resize(height(), width());
+
+    for(int i=0; i<height(); i++) {
+        for(int j=0; j<width(); j++) {
+            imageMatrix(i, j) = YCbCrPixel{y(i, j), cb(i / 2, j / 2), cr(i / 2, j / 2)};
+        }
+    }
+
+    return Image(imageMatrix);
+}
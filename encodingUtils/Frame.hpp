@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdlib>
+#include <memory>
+
+#include "../ImageUtils/Image.hpp"
+
+/**
+ * A single 8 bit sample plane, stored row by row.
+ *
+ * Every row starts at a multiple of ALIGNMENT bytes. A plane may have a border of padding samples on every side,
+ * row(r) and operator() accept positions inside it. extendBorders() fills the border with copies of the outermost
+ * samples, so blocks partly outside the plane read like blocks of an infinitely extended plane.
+ *
+ * Copies reuse the buffer of the target when both planes have the same size.
+ */
+class Plane {
+public:
+    static constexpr int ALIGNMENT = 32;
+
+    Plane() = default;
+    Plane(int width, int height, int padding = 0);
+    Plane(const Plane& other);
+    Plane(Plane&& other) noexcept {
+        swap(other);
+    }
+
+    Plane& operator=(const Plane& other);
+    Plane& operator=(Plane&& other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    int width = 0;
+    int height = 0;
+    int padding = 0;    // samples of border on every side
+    int stride = 0;     // distance between two rows, in samples
+
+    unsigned char* row(int r) {
+        return origin + static_cast<std::ptrdiff_t>(r) * stride;
+    }
+
+    const unsigned char* row(int r) const {
+        return origin + static_cast<std::ptrdiff_t>(r) * stride;
+    }
+
+    unsigned char& operator()(int r, int c) {
+        return row(r)[c];
+    }
+
+    unsigned char operator()(int r, int c) const {
+        return row(r)[c];
+    }
+
+    /**
+     * Fill the border with the closest samples of the plane
+     */
+    void extendBorders();
+
+    void swap(Plane& other) noexcept;
+
+private:
+    class Free {
+    public:
+        void operator()(unsigned char* buffer) const {
+            std::free(buffer);
+        }
+    };
+
+    std::size_t bufferSize() const {
+        return static_cast<std::size_t>(stride) * (height + 2 * padding);
+    }
+
+    std::unique_ptr<unsigned char, Free> data;
+    unsigned char* origin = nullptr;    // the sample (0, 0)
+};
+
+/**
+ * A planar YCbCr 4:2:0 frame: Y at full resolution, Cb and Cr averaged over 2x2 regions, like the 4x4 U and V
+ * blocks of Image::encode
+ */
+class Frame {
+public:
+    Frame() = default;
+
+    /**
+     * @param padding The border of the luma plane, chroma planes get half of it
+     */
+    Frame(int width, int height, int padding = 0): y{width, height, padding},
+                                                   cb{width / 2, height / 2, padding / 2},
+                                                   cr{width / 2, height / 2, padding / 2} {};
+
+    Plane y;
+    Plane cb;
+    Plane cr;
+
+    int frameNumber = 0;    // position of the frame in display order
+
+    int width() const {
+        return y.width;
+    }
+
+    int height() const {
+        return y.height;
+    }
+
+    void extendBorders() {
+        y.extendBorders();
+        cb.extendBorders();
+        cr.extendBorders();
+    }
+
+    /**
+     * Convert an image to a planar frame, subsampling the chroma
+     * @param image The source image
+     */
+    static Frame fromImage(Image& image);
+
+    /**
+     * Convert the frame back to an image, each chroma sample covering a 2x2 region
+     */
+    Image toImage() const;
+};
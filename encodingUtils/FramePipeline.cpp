@@ -0,0 +1,235 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "FramePipeline.hpp"
+#include "ImageReader.hpp"
+#include "RingBuffer.hpp"
+#include "../ImageUtils/Image.hpp"
+
+using namespace std;
+
+namespace {
+    /**
+     * A frame on its way through the pipeline, tagged with its position in the input
+     */
+    class ImageItem {
+    public:
+        size_t index = 0;
+        shared_ptr<Image> image;
+    };
+
+    class BlocksItem {
+    public:
+        size_t index = 0;
+        int blocksPerRow = 0;
+        tuple<vector<Block>, vector<Block>, vector<Block>> blocks;
+    };
+
+    class CodedItem {
+    public:
+        size_t index = 0;
+        CodedFrame frame;
+    };
+
+    void writeInt32(ostream& stream, int32_t value) {
+        unsigned char bytes[4] = {static_cast<unsigned char>(value), static_cast<unsigned char>(value >> 8),
+                                  static_cast<unsigned char>(value >> 16), static_cast<unsigned char>(value >> 24)};
+        stream.write(reinterpret_cast<const char*>(bytes), 4);
+    }
+
+    bool readInt32(istream& stream, int32_t& value) {
+        unsigned char bytes[4] = {0, 0, 0, 0};
+        if(not stream.read(reinterpret_cast<char*>(bytes), 4)) {
+            return false;
+        }
+        value = static_cast<int32_t>(bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24));
+        return true;
+    }
+
+    /**
+     * Runs the workers of a stage and closes the queue after it once the last one is done.
+     * An exception thrown by a worker is handed to fail.
+     */
+    template<class Queue>
+    class Stage {
+    public:
+        Stage(unsigned workers, Queue& output): workers{workers}, remaining{workers}, output{output} {};
+
+        template<class Work, class Fail>
+        void start(vector<thread>& threads, Work work, Fail fail) {
+            for(unsigned w=0; w<workers; w++) {
+                threads.emplace_back([this, work, fail]() {
+                    try {
+                        work();
+                    }
+                    catch(...) {
+                        fail(current_exception());
+                    }
+                    if(--remaining == 0) {
+                        output.close();
+                    }
+                });
+            }
+        }
+
+    private:
+        unsigned workers;
+        atomic<unsigned> remaining;
+        Queue& output;
+    };
+}
+
+size_t FramePipeline::run(const vector<string>& inputs, ostream& output) {
+    for(auto& busy : busyMicroseconds) {
+        busy = 0;
+    }
+    // time one step of a stage
+    auto timed = [this](PipelineStage stage, auto&& step) {
+        auto start = chrono::steady_clock::now();
+        step();
+        auto elapsed = chrono::steady_clock::now() - start;
+        busyMicroseconds[stage] += chrono::duration_cast<chrono::microseconds>(elapsed).count();
+    };
+
+    // the reader is the read stage, it reads ahead on a thread of its own
+    ImageReader reader{inputs, queueCapacity};
+
+    // conversion has a single worker, the other stages may have several on either side of a queue
+    MpmcRing<ImageItem> converted{queueCapacity};
+    MpmcRing<BlocksItem> extracted{queueCapacity};
+    MpmcRing<CodedItem> coded{queueCapacity};
+
+    Stage<MpmcRing<ImageItem>> convertStage{1, converted};
+    Stage<MpmcRing<BlocksItem>> transformStage{transformWorkers, extracted};
+    Stage<MpmcRing<CodedItem>> entropyStage{entropyWorkers, coded};
+    vector<thread> threads;
+
+    // the first error of a stage ends the run, every queue is closed so no stage waits for another
+    mutex errorMutex;
+    exception_ptr error;
+    auto fail = [&](exception_ptr exception) {
+        {
+            lock_guard<mutex> lock{errorMutex};
+            if(not error) {
+                error = move(exception);
+            }
+        }
+        converted.close();
+        extracted.close();
+        coded.close();
+    };
+
+    convertStage.start(threads, [&]() {
+        size_t index = 0;
+        shared_ptr<Image> image;
+        while(reader.next(image)) {
+            ImageItem item;
+            item.index = index++;
+            item.image = move(image);
+            timed(CONVERT_STAGE, [&]() {
+                // converts once, the result is kept by the image
+                item.image->getYCbCrImage();
+            });
+            if(not converted.push(move(item))) {
+                return;
+            }
+        }
+    }, fail);
+
+    transformStage.start(threads, [&]() {
+        ImageItem item;
+        while(converted.pop(item)) {
+            BlocksItem blocks;
+            blocks.index = item.index;
+            timed(TRANSFORM_STAGE, [&]() {
+                blocks.blocksPerRow = item.image->getWidth() / 8;
+                blocks.blocks = pool ? item.image->encode(*pool) : item.image->encode();
+                item.image.reset();
+            });
+            if(not extracted.push(move(blocks))) {
+                return;
+            }
+        }
+    }, fail);
+
+    entropyStage.start(threads, [&]() {
+        BlocksItem item;
+        while(extracted.pop(item)) {
+            CodedItem frame;
+            frame.index = item.index;
+            timed(ENTROPY_STAGE, [&]() {
+                frame.frame = EntropyCoder::encodeFrame(item.blocks, item.blocksPerRow, mode);
+            });
+            if(not coded.push(move(frame))) {
+                return;
+            }
+        }
+    }, fail);
+
+    // several workers may finish out of order, the writer puts the frames back in input order
+    size_t written = 0;
+    try {
+        map<size_t, CodedFrame> pending;
+        CodedItem item;
+        while(coded.pop(item)) {
+            pending.emplace(item.index, move(item.frame));
+            for(auto next = pending.find(written); next != pending.end(); next = pending.find(written)) {
+                timed(WRITE_STAGE, [&]() {
+                    const auto& frame = next->second;
+                    writeInt32(output, frame.mode);
+                    writeInt32(output, frame.blocksPerRow);
+                    writeInt32(output, frame.blockCount);
+                    writeInt32(output, static_cast<int32_t>(frame.bytes.size()));
+                    output.write(reinterpret_cast<const char*>(frame.bytes.data()),
+                                 static_cast<streamsize>(frame.bytes.size()));
+                });
+                pending.erase(next);
+                written++;
+            }
+        }
+    }
+    catch(...) {
+        fail(current_exception());
+    }
+
+    for(auto& t : threads) {
+        t.join();
+    }
+    busyMicroseconds[READ_STAGE] = llround(reader.busySeconds() * 1e6);
+    if(error) {
+        rethrow_exception(error);
+    }
+    return written;
+}
+
+bool FramePipeline::readFrame(istream& input, CodedFrame& frame) {
+    int32_t mode, blocksPerRow, blockCount, size;
+    if(not readInt32(input, mode) || not readInt32(input, blocksPerRow) || not readInt32(input, blockCount)
+       || not readInt32(input, size)) {
+        return false;
+    }
+    if((mode != RUN_LENGTH && mode != ARITHMETIC) || blocksPerRow < 0 || blockCount < 0 || size < 0) {
+        // not a header written by run
+        return false;
+    }
+    frame.mode = static_cast<EntropyMode>(mode);
+    frame.blocksPerRow = blocksPerRow;
+    frame.blockCount = blockCount;
+
+    // grow with the bytes actually read, a damaged size does not allocate the whole of it up front
+    const int32_t CHUNK = 1 << 20;
+    frame.bytes.clear();
+    for(int32_t done=0; done<size; ) {
+        int32_t count = min(CHUNK, size - done);
+        frame.bytes.resize(static_cast<size_t>(done) + count);
+        if(not input.read(reinterpret_cast<char*>(frame.bytes.data()) + done, count)) {
+            return false;
+        }
+        done += count;
+    }
+    return true;
+}
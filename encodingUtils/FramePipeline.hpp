@@ -0,0 +1,76 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "EntropyCoder.hpp"
+#include "ThreadPool.hpp"
+
+/**
+ * The stages of a FramePipeline, in the order a frame goes through them
+ */
+enum PipelineStage {READ_STAGE, CONVERT_STAGE, TRANSFORM_STAGE, ENTROPY_STAGE, WRITE_STAGE};
+
+/**
+ * Encodes a sequence of images with every stage on its own threads: reading, conversion to YCbCr, block extraction,
+ * entropy coding and writing.
+ *
+ * The stages are connected by lock-free ring buffers. While one frame is entropy coded the next ones are extracted,
+ * converted and read, a stage that runs ahead waits for the one after it, so at most a few frames are in memory at a
+ * time. The throughput is the one of the slowest stage, which can be given more workers.
+ *
+ * Output layout (little endian), per frame in input order: int32 entropy mode, int32 blocks per row, int32 block count,
+ * int32 byte count, then the bytes of the CodedFrame.
+ */
+class FramePipeline {
+public:
+    static constexpr int STAGE_COUNT = 5;
+
+    /**
+     * @param mode The entropy mode of every frame
+     * @param queueCapacity The number of frames a queue between two stages holds, rounded up to a power of two
+     * @param transformWorkers The number of threads extracting blocks
+     * @param entropyWorkers The number of threads entropy coding
+     * @param pool A scheduler shared with other stages, the block rows of a frame are extracted on it.
+     *             nullptr extracts every frame on its transform worker.
+     */
+    explicit FramePipeline(EntropyMode mode, std::size_t queueCapacity = 2, unsigned transformWorkers = 1,
+                           unsigned entropyWorkers = 1, ThreadPool* pool = nullptr):
+            mode{mode}, queueCapacity{std::max<std::size_t>(1, queueCapacity)},
+            transformWorkers{std::max(1U, transformWorkers)}, entropyWorkers{std::max(1U, entropyWorkers)},
+            pool{pool} {};
+
+    /**
+     * Encode images and write them to output
+     * @param inputs The file names of the images, in order
+     * @param output The stream to write the coded frames to
+     * @return The number of frames written
+     * @throw The first error of a stage, e.g. an image that cannot be read. The frames before it may be written.
+     */
+    std::size_t run(const std::vector<std::string>& inputs, std::ostream& output);
+
+    /**
+     * @return The time the workers of a stage spent working during the last run, in seconds, summed over the workers
+     */
+    double busySeconds(PipelineStage stage) const {
+        return busyMicroseconds[stage] / 1e6;
+    }
+
+    /**
+     * Read the next frame written by run
+     * @return false at the end of the stream, or if the header is invalid or the bytes are truncated
+     */
+    static bool readFrame(std::istream& input, CodedFrame& frame);
+
+private:
+    EntropyMode mode;
+    std::size_t queueCapacity;
+    unsigned transformWorkers;
+    unsigned entropyWorkers;
+    ThreadPool* pool;
+
+    std::atomic<long long> busyMicroseconds[STAGE_COUNT] = {};
+};
@@ -0,0 +1,85 @@
+#include <chrono>
+#include <fstream>
+#include <istream>
+#include <stdexcept>
+#include "ImageReader.hpp"
+
+using namespace std;
+
+namespace {
+    /**
+     * Lets an istream read a buffer in memory without copying it
+     */
+    class BufferSource : public streambuf {
+    public:
+        BufferSource(char* data, size_t size) {
+            setg(data, data, data + size);
+        }
+    };
+
+    long long microsecondsSince(chrono::steady_clock::time_point start) {
+        return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+    }
+}
+
+ImageReader::ImageReader(vector<string> files, size_t depth):
+        files{move(files)}, pictures{[]() { return make_unique<Image>(); }}, images{max<size_t>(1, depth)} {
+    thread = std::thread([this]() {
+        readAll();
+    });
+}
+
+ImageReader::~ImageReader() {
+    // wakes the reader if it waits for a free place, its next push fails
+    images.close();
+    thread.join();
+}
+
+bool ImageReader::next(shared_ptr<Image>& image) {
+    auto start = chrono::steady_clock::now();
+    bool found = images.pop(image);
+    waitMicroseconds += microsecondsSince(start);
+
+    if(not found && error) {
+        // the reader sets error before closing the ring, the failed pop saw the close
+        rethrow_exception(error);
+    }
+    return found;
+}
+
+void ImageReader::readAll() {
+    vector<char> buffer;
+    try {
+        for(const auto& file : files) {
+            auto start = chrono::steady_clock::now();
+
+            ifstream input(file, ios::binary | ios::ate);
+            if(not input) {
+                throw runtime_error("cannot open " + file);
+            }
+            auto size = static_cast<size_t>(input.tellg());
+            buffer.resize(size);
+            input.seekg(0);
+            input.read(buffer.data(), static_cast<streamsize>(size));
+            if(static_cast<size_t>(input.gcount()) != size) {
+                // the rest of the buffer still holds the previous file
+                throw runtime_error("short read of " + file);
+            }
+
+            BufferSource source{buffer.data(), size};
+            istream stream{&source};
+            auto image = pictures.acquire();
+            image->read(stream);
+            busyMicroseconds += microsecondsSince(start);
+
+            if(not images.push(move(image))) {
+                // closed by the destructor
+                return;
+            }
+        }
+    }
+    catch(...) {
+        error = current_exception();
+    }
+    images.close();
+}
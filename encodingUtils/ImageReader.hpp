@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Pool.hpp"
+#include "RingBuffer.hpp"
+#include "../ImageUtils/Image.hpp"
+
+/**
+ * Reads a sequence of image files ahead of their consumer, on a thread of its own.
+ *
+ * While the consumer works on one image the next ones are read and parsed, at most depth of them wait in a ring, so
+ * the consumer finds its next image ready unless reading is slower than the consumer. Every file is read to memory
+ * with a single read into a buffer reused for all files, and parsed from there into an image taken from a pool.
+ * Released images go back to the pool, so once every image in flight exists no new ones are allocated.
+ *
+ * Images come out in the order of the files. An error reading a file, a file shorter than its size included, ends the
+ * sequence and is thrown by next().
+ */
+class ImageReader {
+public:
+    /**
+     * Start reading
+     * @param files The file names of the images, in order
+     * @param depth The number of images read ahead, 2 is double buffering
+     */
+    explicit ImageReader(std::vector<std::string> files, std::size_t depth = 2);
+
+    /**
+     * Stop reading, the images read ahead are dropped
+     */
+    ~ImageReader();
+
+    ImageReader(const ImageReader&) = delete;
+    ImageReader& operator=(const ImageReader&) = delete;
+
+    /**
+     * Take the next image, waiting for it if it is not read yet
+     * @param image Set to the image, it goes back to the pool when its last copy is released
+     * @return false at the end of the sequence
+     */
+    bool next(std::shared_ptr<Image>& image);
+
+    /**
+     * @return The time spent reading and parsing so far, in seconds
+     */
+    double busySeconds() const {
+        return busyMicroseconds / 1e6;
+    }
+
+    /**
+     * @return The time next() spent waiting for an image so far, in seconds. Close to 0 when reading keeps up.
+     */
+    double waitSeconds() const {
+        return waitMicroseconds / 1e6;
+    }
+
+private:
+    void readAll();
+
+    std::vector<std::string> files;
+    Pool<Image> pictures;
+    SpscRing<std::shared_ptr<Image>> images;
+    std::exception_ptr error;
+
+    std::atomic<long long> busyMicroseconds{0};
+    std::atomic<long long> waitMicroseconds{0};
+
+    std::thread thread;
+};
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <vector>
+#include "Interpolation.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+    unsigned char filter(int t0, int t1, int t2, int t3, int t4, int t5) {
+        int value = (t0 + t5 - 5 * (t1 + t4) + 20 * (t2 + t3) + 16) >> 5;
+        return static_cast<unsigned char>(max(0, min(255, value)));
+    }
+
+    /**
+     * Filter every column of the source, border included. The output row r lies between the source rows r and r + 1.
+     */
+    void filterVertical(const Plane& source, Plane& output) {
+        int first = -source.padding, last = source.height + source.padding - 1;
+        for(int r=first; r<=last; r++) {
+            const unsigned char* taps[6];
+            for(int k=0; k<6; k++) {
+                taps[k] = source.row(max(first, min(last, r + k - 2))) - source.padding;
+            }
+            InterpolatedPlane::filterRow(taps, output.row(r) - source.padding, source.width + 2 * source.padding);
+        }
+    }
+}
+
+void InterpolatedPlane::filterRowScalar(const unsigned char* const taps[6], unsigned char* output, int width) {
+    for(int j=0; j<width; j++) {
+        output[j] = filter(taps[0][j], taps[1][j], taps[2][j], taps[3][j], taps[4][j], taps[5][j]);
+    }
+}
+
+void InterpolatedPlane::filterRow(const unsigned char* const taps[6], unsigned char* output, int width) {
+    int j = 0;
+
+#ifdef __SSE2__
+    // 8 samples at a time in 16 bits, the intermediate sums stay within -2550..10710
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i five = _mm_set1_epi16(5), twenty = _mm_set1_epi16(20), rounding = _mm_set1_epi16(16);
+    for(; j + 8 <= width; j+=8) {
+        __m128i t[6];
+        for(int k=0; k<6; k++) {
+            t[k] = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(taps[k] + j)), zero);
+        }
+        __m128i sum = _mm_add_epi16(_mm_add_epi16(t[0], t[5]), rounding);
+        sum = _mm_sub_epi16(sum, _mm_mullo_epi16(_mm_add_epi16(t[1], t[4]), five));
+        sum = _mm_add_epi16(sum, _mm_mullo_epi16(_mm_add_epi16(t[2], t[3]), twenty));
+        // packus clamps to 0..255
+        __m128i result = _mm_packus_epi16(_mm_srai_epi16(sum, 5), zero);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(output + j), result);
+    }
+#endif
+
+    const unsigned char* rest[6];
+    for(int k=0; k<6; k++) {
+        rest[k] = taps[k] + j;
+    }
+    filterRowScalar(rest, output + j, width - j);
+}
+
+void InterpolatedPlane::interpolate(const Plane& full, Plane& horizontal, Plane& vertical, Plane& diagonal) {
+    int paddedWidth = full.width + 2 * full.padding;
+
+    // horizontal taps from a copy of the row with its outermost samples repeated
+    vector<unsigned char> padded(static_cast<size_t>(paddedWidth) + 5);
+    for(int r=-full.padding; r<full.height + full.padding; r++) {
+        auto row = full.row(r) - full.padding;
+        for(int j=0; j<static_cast<int>(padded.size()); j++) {
+            padded[j] = row[max(0, min(paddedWidth - 1, j - 2))];
+        }
+        const unsigned char* taps[6];
+        for(int k=0; k<6; k++) {
+            taps[k] = padded.data() + k;
+        }
+        filterRow(taps, horizontal.row(r) - full.padding, paddedWidth);
+    }
+
+    filterVertical(full, vertical);
+    filterVertical(horizontal, diagonal);
+}
+
+const unsigned char* InterpolatedPlane::halfSample(int halfRow, int halfCol) const {
+    const Plane* plane;
+    if(halfRow & 1) {
+        plane = halfCol & 1 ? &diagonal : &vertical;
+    }
+    else {
+        plane = halfCol & 1 ? &horizontal : &full;
+    }
+    return plane->row(halfRow >> 1) + (halfCol >> 1);
+}
+
+void InterpolatedPlane::predict(int top, int left, int size, const MotionVector& mv, unsigned char* output,
+                                int outputStride) const {
+    int quarterRow = 4 * top + mv.dy, quarterCol = 4 * left + mv.dx;
+    int fractionRow = quarterRow & 3, fractionCol = quarterCol & 3;
+
+    // the one or two half sample positions to average, in half samples
+    int rowA, colA, rowB, colB;
+    if(fractionRow % 2 == 1 && fractionCol % 2 == 1) {
+        // diagonal: the closest horizontal and vertical half samples
+        int baseRow = 2 * (quarterRow >> 2), baseCol = 2 * (quarterCol >> 2);
+        rowA = baseRow + (fractionRow == 1 ? 0 : 2), colA = baseCol + 1;
+        rowB = baseRow + 1, colB = baseCol + (fractionCol == 1 ? 0 : 2);
+    }
+    else {
+        rowA = quarterRow >> 1, colA = quarterCol >> 1;
+        rowB = (quarterRow + 1) >> 1, colB = (quarterCol + 1) >> 1;
+    }
+
+    // the four planes have the same layout
+    auto a = halfSample(rowA, colA), b = halfSample(rowB, colB);
+    for(int i=0; i<size; i++) {
+        auto out = output + i * outputStride;
+        auto rowOfA = a + i * full.stride, rowOfB = b + i * full.stride;
+        if(a == b) {
+            copy(rowOfA, rowOfA + size, out);
+            continue;
+        }
+        for(int j=0; j<size; j++) {
+            out[j] = static_cast<unsigned char>((rowOfA[j] + rowOfB[j] + 1) >> 1);
+        }
+    }
+}
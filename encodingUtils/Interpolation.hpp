@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Frame.hpp"
+#include "MotionVector.hpp"
+
+/**
+ * A reference plane with its half sample positions, interpolated once per reference frame with the 6-tap filter
+ * (1, -5, 20, 20, -5, 1) / 32. Quarter sample positions are the rounded average of the two closest integer or
+ * half sample positions, the diagonal ones of the two closest horizontal and vertical half sample positions.
+ *
+ * A view of the planes of an InterpolatedFrame, which owns them.
+ */
+class InterpolatedPlane {
+public:
+    InterpolatedPlane(const Plane& full, const Plane& horizontal, const Plane& vertical, const Plane& diagonal):
+            full{full}, horizontal{horizontal}, vertical{vertical}, diagonal{diagonal} {};
+
+    const Plane& full;
+    const Plane& horizontal;    // between every sample and the one right of it
+    const Plane& vertical;      // between every sample and the one below it
+    const Plane& diagonal;      // between 4 samples, the horizontal half samples filtered vertically
+
+    /**
+     * Write the samples of a displaced block
+     * @param mv The displacement in quarter samples. The block and the samples right of and below it, if the
+     *           displacement has a fractional part, must be inside the plane or its border.
+     */
+    void predict(int top, int left, int size, const MotionVector& mv, unsigned char* output, int outputStride) const;
+
+    /**
+     * Interpolate the half sample positions of a plane, its border included. Taps outside the border repeat the
+     * outermost samples.
+     * @param full The plane, its border already extended
+     */
+    static void interpolate(const Plane& full, Plane& horizontal, Plane& vertical, Plane& diagonal);
+
+    /**
+     * Filter a row of half sample positions, output[j] from taps[0][j] to taps[5][j]
+     */
+    static void filterRow(const unsigned char* const taps[6], unsigned char* output, int width);
+    static void filterRowScalar(const unsigned char* const taps[6], unsigned char* output, int width);
+
+private:
+    /**
+     * @return The sample at a position in half samples, in the plane holding it
+     */
+    const unsigned char* halfSample(int halfRow, int halfCol) const;
+};
+
+/**
+ * A reference frame: its samples with a border for motion vectors pointing outside of it, and its interpolated half
+ * sample positions
+ */
+class InterpolatedFrame {
+public:
+    // luma border, blocks may be displaced up to MotionEstimator::MAX_OUTSIDE samples outside the frame and the
+    // filter reads 3 samples further
+    static constexpr int PADDING = 32;
+
+    InterpolatedFrame(int width, int height): frame{width, height, PADDING}, horizontal{width, height, PADDING},
+                                              vertical{width, height, PADDING}, diagonal{width, height, PADDING} {};
+
+    Frame frame;        // the integer sample positions
+    Frame horizontal;
+    Frame vertical;
+    Frame diagonal;
+
+    /**
+     * Extend the border of the frame and interpolate it, once its samples are written
+     */
+    void interpolate() {
+        frame.extendBorders();
+        InterpolatedPlane::interpolate(frame.y, horizontal.y, vertical.y, diagonal.y);
+        InterpolatedPlane::interpolate(frame.cb, horizontal.cb, vertical.cb, diagonal.cb);
+        InterpolatedPlane::interpolate(frame.cr, horizontal.cr, vertical.cr, diagonal.cr);
+    }
+
+    InterpolatedPlane y() const {
+        return InterpolatedPlane{frame.y, horizontal.y, vertical.y, diagonal.y};
+    }
+
+    InterpolatedPlane cb() const {
+        return InterpolatedPlane{frame.cb, horizontal.cb, vertical.cb, diagonal.cb};
+    }
+
+    InterpolatedPlane cr() const {
+        return InterpolatedPlane{frame.cr, horizontal.cr, vertical.cr, diagonal.cr};
+    }
+};
@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include "MotionCompensation.hpp"
+
+using namespace std;
+
+Matrix<int, Dynamic, Dynamic> MotionCompensation::predict(const InterpolatedPlane& reference, int top, int left,
+                                                          int size, const MotionVector& mv) {
+    unsigned char samples[8 * 8];
+    reference.predict(top, left, size, mv, samples, 8);
+
+    Matrix<int, Dynamic, Dynamic> prediction;
+    prediction.resize(size, size);
+    for(int i=0; i<size; i++) {
+        for(int j=0; j<size; j++) {
+            prediction(i, j) = samples[8 * i + j];
+        }
+    }
+
+    return prediction;
+}
+
+Matrix<int, Dynamic, Dynamic> MotionCompensation::predict(PredictionDirection direction,
+                                                          const InterpolatedPlane& forward,
+                                                          const InterpolatedPlane& backward, int top, int left,
+                                                          int size, const MotionVector& forwardMv,
+                                                          const MotionVector& backwardMv) {
+    switch(direction) {
+        case FORWARD:
+            return predict(forward, top, left, size, forwardMv);
+        case BACKWARD:
+            return predict(backward, top, left, size, backwardMv);
+        case BIDIRECTIONAL:
+        default:
+            // a plain matrix, an expression would refer to the destroyed predictions
+            Matrix<int, Dynamic, Dynamic> sum = predict(forward, top, left, size, forwardMv)
+                     + predict(backward, top, left, size, backwardMv);
+            return sum.unaryExpr([](int value) {
+                return (value + 1) / 2;
+            });
+    }
+}
+
+void MotionCompensation::copy(const Plane& reference, Plane& target, int top, int left, int size) {
+    for(int i=0; i<size; i++) {
+        memcpy(target.row(top + i) + left, reference.row(top + i) + left, size);
+    }
+}
+
+Matrix<int, Dynamic, Dynamic> MotionCompensation::residual(const Plane& source, int top, int left,
+                                                           const Matrix<int, Dynamic, Dynamic>& prediction) {
+    Matrix<int, Dynamic, Dynamic> output;
+    output.resize(prediction.rows(), prediction.cols());
+
+    for(int i=0; i<prediction.rows(); i++) {
+        auto sourceRow = source.row(top + i) + left;
+        for(int j=0; j<prediction.cols(); j++) {
+            output(i, j) = sourceRow[j] - prediction(i, j);
+        }
+    }
+
+    return output;
+}
+
+void MotionCompensation::quantize(Matrix<int, Dynamic, Dynamic>& residual, int quantizer, bool intra) {
+    if(quantizer == 1) {
+        return;
+    }
+    int roundingOffset = intra ? quantizer / 3 : quantizer / 6;
+    for(int i=0; i<residual.rows(); i++) {
+        for(int j=0; j<residual.cols(); j++) {
+            int value = residual(i, j);
+            int level = (abs(value) + roundingOffset) / quantizer;
+            residual(i, j) = value < 0 ? -level : level;
+        }
+    }
+}
+
+void MotionCompensation::reconstruct(Plane& target, int top, int left, const Matrix<int, Dynamic, Dynamic>& prediction,
+                                     const Matrix<int, Dynamic, Dynamic>& residual) {
+    for(int i=0; i<prediction.rows(); i++) {
+        auto targetRow = target.row(top + i) + left;
+        for(int j=0; j<prediction.cols(); j++) {
+            targetRow[j] = static_cast<unsigned char>(max(0, min(255, prediction(i, j) + residual(i, j))));
+        }
+    }
+}
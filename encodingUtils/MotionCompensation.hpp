@@ -0,0 +1,80 @@
+#pragma once
+
+#include "../Eigen/Dense"
+#include "EncodedFrame.hpp"
+#include "Frame.hpp"
+#include "Interpolation.hpp"
+#include "MotionVector.hpp"
+
+using Eigen::Matrix;
+using Eigen::Dynamic;
+
+/**
+ * Prediction and reconstruction of blocks, shared by the video encoder and decoder
+ */
+class MotionCompensation {
+public:
+    // prediction of intra blocks, the middle of the sample range
+    static constexpr int INTRA_PREDICTION = 128;
+
+    /**
+     * Interpolate a block of the reference displaced by a motion vector
+     * @param reference The interpolated reference plane
+     * @param top The top row of the block in the current frame
+     * @param left The left column of the block in the current frame
+     * @param size The size of the square block, at most 8
+     * @param mv The displacement in quarter samples, must keep the block inside the reference
+     */
+    static Matrix<int, Dynamic, Dynamic> predict(const InterpolatedPlane& reference, int top, int left, int size,
+                                                 const MotionVector& mv);
+
+    /**
+     * Prediction of a B frame block from one of its references or the rounded average of both
+     * @param direction The reference(s) to predict from
+     * @param forward The earlier reference plane
+     * @param backward The later reference plane
+     * @param forwardMv The displacement in the earlier reference, ignored for BACKWARD
+     * @param backwardMv The displacement in the later reference, ignored for FORWARD
+     */
+    static Matrix<int, Dynamic, Dynamic> predict(PredictionDirection direction, const InterpolatedPlane& forward,
+                                                 const InterpolatedPlane& backward, int top, int left, int size,
+                                                 const MotionVector& forwardMv, const MotionVector& backwardMv);
+
+    /**
+     * Copy the co-located block of the reference to the target
+     */
+    static void copy(const Plane& reference, Plane& target, int top, int left, int size);
+
+    /**
+     * @return The displacement of a chroma block for the motion vector of its luma block, in quarter chroma samples
+     */
+    static MotionVector chromaVector(const MotionVector& mv) {
+        return MotionVector{mv.dx / 2, mv.dy / 2};
+    }
+
+    /**
+     * @return The difference between a block of the source plane and its prediction
+     */
+    static Matrix<int, Dynamic, Dynamic> residual(const Plane& source, int top, int left,
+                                                  const Matrix<int, Dynamic, Dynamic>& prediction);
+
+    /**
+     * Divide a residual by the quantizer. Values round towards 0 unless they are within a third (intra) or a sixth
+     * (inter) of the quantizer from the next level, the dead zone keeps the reconstruction error of the reference
+     * from being coded again in every following frame.
+     */
+    static void quantize(Matrix<int, Dynamic, Dynamic>& residual, int quantizer, bool intra);
+
+    /**
+     * Scale a quantized residual back, the inverse of quantize up to the rounding
+     */
+    static void dequantize(Matrix<int, Dynamic, Dynamic>& residual, int quantizer) {
+        residual *= quantizer;
+    }
+
+    /**
+     * Write prediction + residual to a block of the target plane, clamped to the sample range
+     */
+    static void reconstruct(Plane& target, int top, int left, const Matrix<int, Dynamic, Dynamic>& prediction,
+                            const Matrix<int, Dynamic, Dynamic>& residual);
+};
@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include "MotionEstimator.hpp"
+#include "BlockCost.hpp"
+
+using namespace std;
+
+namespace {
+    const vector<MotionVector> LARGE_DIAMOND = {{0, -2}, {1, -1}, {2, 0}, {1, 1}, {0, 2}, {-1, 1}, {-2, 0}, {-1, -1}};
+    const vector<MotionVector> HEXAGON = {{-2, 0}, {-1, -2}, {1, -2}, {2, 0}, {1, 2}, {-1, 2}};
+    const vector<MotionVector> SMALL_DIAMOND = {{0, -1}, {1, 0}, {0, 1}, {-1, 0}};
+    const vector<MotionVector> SQUARE = {{-1, -1}, {0, -1}, {1, -1}, {-1, 0}, {1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+
+    /**
+     * Average each 2x2 region of a plane to a single sample
+     */
+    void downsample(const Plane& source, Plane& target) {
+        if(target.width != source.width / 2 || target.height != source.height / 2) {
+            target = Plane{source.width / 2, source.height / 2};
+        }
+
+        for(int i=0; i<target.height; i++) {
+            auto top = source.row(2 * i), bottom = source.row(2 * i + 1);
+            auto out = target.row(i);
+            for(int j=0; j<target.width; j++) {
+                out[j] = static_cast<unsigned char>((top[2 * j] + top[2 * j + 1] + bottom[2 * j] + bottom[2 * j + 1] + 2) / 4);
+            }
+        }
+    }
+}
+
+/**
+ * The best candidate of one block search so far
+ */
+class MotionEstimator::SearchState {
+public:
+    SearchState(const Plane& current, const Plane& reference, int top, int left, int searchRange, int earlyTermination):
+            current{current}, reference{reference}, top{top}, left{left}, earlyTermination{earlyTermination} {
+        // keep every candidate inside the reference and its border
+        minDy = max(-searchRange, -top - MAX_OUTSIDE);
+        maxDy = min(searchRange, reference.height - BLOCK_SIZE - top + MAX_OUTSIDE);
+        minDx = max(-searchRange, -left - MAX_OUTSIDE);
+        maxDx = min(searchRange, reference.width - BLOCK_SIZE - left + MAX_OUTSIDE);
+    }
+
+    /**
+     * @return The SAD of a candidate, INT_MAX outside of the search area
+     */
+    int cost(const MotionVector& mv) const {
+        if(mv.dx < minDx || mv.dx > maxDx || mv.dy < minDy || mv.dy > maxDy) {
+            return INT_MAX;
+        }
+        return BlockCost::sad8x8(current.row(top) + left, current.stride,
+                                 reference.row(top + mv.dy) + left + mv.dx, reference.stride);
+    }
+
+    /**
+     * Evaluate a candidate
+     * @return true if it became the best candidate
+     */
+    bool check(const MotionVector& mv) {
+        return offer(mv, cost(mv));
+    }
+
+    /**
+     * Compete a candidate whose cost is known
+     * @return true if it became the best candidate
+     */
+    bool offer(const MotionVector& mv, int cost) {
+        if(cost == INT_MAX) {
+            return false;
+        }
+
+        // on equal cost prefer the shorter vector
+        if(cost < bestCost || (cost == bestCost && abs(mv.dx) + abs(mv.dy) < abs(best.dx) + abs(best.dy))) {
+            bestCost = cost;
+            best = mv;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @return true if the best candidate is good enough to stop searching
+     */
+    bool done() const {
+        return bestCost <= earlyTermination;
+    }
+
+    const Plane& current;
+    const Plane& reference;
+    int top, left;
+    int earlyTermination;
+    int minDx, maxDx, minDy, maxDy;
+
+    MotionVector best{0, 0};
+    int bestCost = INT_MAX;
+};
+
+void MotionEstimator::prepare(const Plane& current, const Plane& reference) {
+    if(strategy == PYRAMID_SEARCH) {
+        downsample(current, coarseCurrent);
+        downsample(reference, coarseReference);
+    }
+}
+
+MotionVector MotionEstimator::medianPredictor(const std::vector<MotionVector>& vectors, int blockIdx, int blocksPerRow) {
+    int col = blockIdx % blocksPerRow;
+    MotionVector leftMv, aboveMv, aboveRightMv;
+
+    if(col > 0) {
+        leftMv = vectors[blockIdx - 1];
+    }
+    if(blockIdx >= blocksPerRow) {
+        aboveMv = vectors[blockIdx - blocksPerRow];
+        aboveRightMv = col + 1 < blocksPerRow ? vectors[blockIdx - blocksPerRow + 1] : aboveMv;
+    }
+
+    auto median = [](int a, int b, int c) {
+        return max(min(a, b), min(max(a, b), c));
+    };
+    return MotionVector{median(leftMv.dx, aboveMv.dx, aboveRightMv.dx), median(leftMv.dy, aboveMv.dy, aboveRightMv.dy)};
+}
+
+MotionVector MotionEstimator::search(const Plane& current, const InterpolatedPlane& reference, int top, int left,
+                                     const std::vector<MotionVector>& predictors) const {
+    SearchState state{current, reference.full, top, left, searchRange, earlyTermination};
+
+    // starting points: no motion and the vectors of the neighbours, rounded to integer positions
+    state.check(MotionVector{0, 0});
+    for(const auto& predictor : predictors) {
+        if(state.done()) {
+            return MotionVector{4 * state.best.dx, 4 * state.best.dy};
+        }
+        state.check(MotionVector{(predictor.dx + 2) >> 2, (predictor.dy + 2) >> 2});
+    }
+
+    switch(strategy) {
+        case FULL_SEARCH:
+            fullSearch(state);
+            break;
+        case DIAMOND_SEARCH:
+            patternSearch(state, LARGE_DIAMOND);
+            break;
+        case HEXAGON_SEARCH:
+            patternSearch(state, HEXAGON);
+            break;
+        case PYRAMID_SEARCH:
+            pyramidSearch(state, predictors);
+            break;
+    }
+
+    return subpelSearch(state, reference);
+}
+
+MotionVector MotionEstimator::subpelSearch(const SearchState& state, const InterpolatedPlane& reference) const {
+    MotionVector best{4 * state.best.dx, 4 * state.best.dy};
+    int bestCost = state.bestCost;
+    if(state.done()) {
+        return best;
+    }
+
+    // the interpolated block and the samples right of and below it must be inside the reference and its border
+    auto inside = [&state](const MotionVector& mv) {
+        return mv.dx >> 2 >= state.minDx && (mv.dx + 3) >> 2 <= state.maxDx
+            && mv.dy >> 2 >= state.minDy && (mv.dy + 3) >> 2 <= state.maxDy;
+    };
+
+    unsigned char prediction[BLOCK_SIZE * BLOCK_SIZE];
+    auto source = state.current.row(state.top) + state.left;
+
+    // the 8 half sample positions around the integer vector, then the 8 quarter sample positions around the best
+    for(int step=2; step>=1 && step >= 4 >> subpelRefinement; step/=2) {
+        auto centre = best;
+        for(const auto& offset : SQUARE) {
+            MotionVector mv{centre.dx + step * offset.dx, centre.dy + step * offset.dy};
+            if(not inside(mv)) {
+                continue;
+            }
+
+            reference.predict(state.top, state.left, BLOCK_SIZE, mv, prediction, BLOCK_SIZE);
+            int cost = BlockCost::sad8x8(source, state.current.stride, prediction, BLOCK_SIZE);
+            if(cost < bestCost) {
+                bestCost = cost;
+                best = mv;
+            }
+        }
+    }
+
+    return best;
+}
+
+void MotionEstimator::fullSearch(SearchState& state) const {
+    for(int dy=state.minDy; dy<=state.maxDy && not state.done(); dy++) {
+        for(int dx=state.minDx; dx<=state.maxDx; dx++) {
+            state.check(MotionVector{dx, dy});
+        }
+    }
+}
+
+void MotionEstimator::patternSearch(SearchState& state, const std::vector<MotionVector>& pattern) const {
+    // move the pattern to its best point until the centre is the best, then refine with the small diamond
+    bool moved = true;
+    while(moved && not state.done()) {
+        moved = false;
+        auto centre = state.best;
+        for(const auto& step : pattern) {
+            moved |= state.check(MotionVector{centre.dx + step.dx, centre.dy + step.dy});
+        }
+    }
+
+    auto centre = state.best;
+    for(const auto& step : SMALL_DIAMOND) {
+        state.check(MotionVector{centre.dx + step.dx, centre.dy + step.dy});
+    }
+}
+
+void MotionEstimator::pyramidSearch(SearchState& state, const std::vector<MotionVector>& predictors) const {
+    // full search of the half size block on the half resolution planes
+    const int coarseSize = BLOCK_SIZE / 2;
+    int coarseTop = state.top / 2, coarseLeft = state.left / 2;
+    int range = searchRange / 2;
+
+    int minDy = max(-range, -coarseTop), maxDy = min(range, coarseReference.height - coarseSize - coarseTop);
+    int minDx = max(-range, -coarseLeft), maxDx = min(range, coarseReference.width - coarseSize - coarseLeft);
+    auto source = coarseCurrent.row(coarseTop) + coarseLeft;
+
+    MotionVector coarseBest{0, 0};
+    int coarseCost = INT_MAX;
+    for(int dy=minDy; dy<=maxDy; dy++) {
+        for(int dx=minDx; dx<=maxDx; dx++) {
+            int cost = BlockCost::sadScalar(source, coarseCurrent.stride,
+                                            coarseReference.row(coarseTop + dy) + coarseLeft + dx,
+                                            coarseReference.stride, coarseSize);
+            if(cost < coarseCost) {
+                coarseCost = cost;
+                coarseBest = MotionVector{dx, dy};
+            }
+        }
+    }
+
+    // refine the scaled coarse vector and every predictor with the small diamond, each from its own start, so a
+    // neighbour that loses to the coarse vector before refinement still gets the chance to win after it
+    vector<MotionVector> starts{MotionVector{2 * coarseBest.dx, 2 * coarseBest.dy}};
+    for(const auto& predictor : predictors) {
+        starts.push_back(MotionVector{(predictor.dx + 2) >> 2, (predictor.dy + 2) >> 2});
+    }
+
+    for(size_t i=0; i<starts.size() && not state.done(); i++) {
+        if(find_if(starts.begin(), starts.begin() + i, [&](const MotionVector& mv) {
+            return mv.dx == starts[i].dx && mv.dy == starts[i].dy;
+        }) != starts.begin() + i) {
+            // several neighbours often share a vector
+            continue;
+        }
+
+        auto centre = starts[i];
+        int centreCost = state.cost(centre);
+        state.offer(centre, centreCost);
+        bool moved = centreCost != INT_MAX;
+        while(moved && not state.done()) {
+            moved = false;
+            auto previous = centre;
+            for(const auto& step : SMALL_DIAMOND) {
+                MotionVector mv{previous.dx + step.dx, previous.dy + step.dy};
+                int cost = state.cost(mv);
+                state.offer(mv, cost);
+                if(cost < centreCost) {
+                    centreCost = cost;
+                    centre = mv;
+                    moved = true;
+                }
+            }
+        }
+    }
+}
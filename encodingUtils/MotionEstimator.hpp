@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+
+#include "EncoderSettings.hpp"
+#include "Frame.hpp"
+#include "Interpolation.hpp"
+#include "MotionVector.hpp"
+
+/**
+ * Block matching motion search on the luma plane
+ */
+class MotionEstimator {
+public:
+    static constexpr int BLOCK_SIZE = 8;
+    // how far a block may be displaced outside the reference, into its border of repeated samples. The luma border
+    // of an InterpolatedFrame leaves room for it and the filter taps, the chroma border for half of it.
+    static constexpr int MAX_OUTSIDE = 16;
+
+    explicit MotionEstimator(int searchRange, SearchStrategy strategy = FULL_SEARCH, int earlyTermination = 0,
+                             int subpelRefinement = 0):
+            searchRange{searchRange}, strategy{strategy}, earlyTermination{earlyTermination},
+            subpelRefinement{subpelRefinement} {};
+
+    int searchRange;
+    SearchStrategy strategy;
+    int earlyTermination;
+    int subpelRefinement;   // 0: integer vectors, 1: half sample refinement, 2: half and quarter sample refinement
+
+    /**
+     * Prepare the search of a new frame. Must be called before the first search of every frame.
+     * @param current The luma plane being encoded
+     * @param reference The reconstructed luma plane of the reference frame
+     */
+    void prepare(const Plane& current, const Plane& reference);
+
+    /**
+     * Find the displacement of an 8x8 block in the reference with the lowest sum of absolute differences.
+     * The search runs on integer positions, the best one is then refined to half and quarter sample positions.
+     * Candidates are limited to blocks at most MAX_OUTSIDE samples outside the reference.
+     * @param current The luma plane being encoded
+     * @param reference The interpolated reconstructed luma plane of the reference frame, with a border of at least
+     *                  MAX_OUTSIDE + 3 samples
+     * @param top The top row of the block
+     * @param left The left column of the block
+     * @param predictors Vectors of neighbouring blocks, used as starting points
+     * @return The displacement in quarter samples
+     */
+    MotionVector search(const Plane& current, const InterpolatedPlane& reference, int top, int left,
+                        const std::vector<MotionVector>& predictors) const;
+
+    /**
+     * Median of the left, upper and upper right vectors of a block, the usual starting point of a search.
+     * Neighbours outside the frame count as zero vectors.
+     * @param vectors The vectors of the blocks coded so far, in raster order
+     * @param blockIdx The index of the current block
+     * @param blocksPerRow The number of blocks in a block row
+     */
+    static MotionVector medianPredictor(const std::vector<MotionVector>& vectors, int blockIdx, int blocksPerRow);
+
+private:
+    class SearchState;
+
+    void fullSearch(SearchState& state) const;
+    void patternSearch(SearchState& state, const std::vector<MotionVector>& pattern) const;
+    void pyramidSearch(SearchState& state, const std::vector<MotionVector>& predictors) const;
+    MotionVector subpelSearch(const SearchState& state, const InterpolatedPlane& reference) const;
+
+    Plane coarseCurrent;
+    Plane coarseReference;
+};
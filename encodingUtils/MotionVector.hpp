@@ -0,0 +1,18 @@
+#pragma once
+
+/**
+ * Displacement of a block in the reference frame. The coded vectors are in quarter luma samples, the integer
+ * searches of MotionEstimator work in whole samples.
+ */
+class MotionVector {
+public:
+    MotionVector() = default;
+    MotionVector(int dx, int dy): dx{dx}, dy{dy} {};
+
+    int dx = 0;
+    int dy = 0;
+
+    bool operator==(const MotionVector& other) const {
+        return dx == other.dx && dy == other.dy;
+    }
+};
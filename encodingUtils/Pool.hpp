@@ -0,0 +1,69 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * Recycles objects of one kind, e.g. frames of one size.
+ *
+ * acquire() hands out a reference counted pointer. When its last copy is released the object goes back to the pool
+ * instead of being freed, so once every object in flight exists no new ones are created. Released objects keep their
+ * contents. The pool may be destroyed before the objects it handed out.
+ */
+template<class T>
+class Pool {
+public:
+    /**
+     * @param factory Creates a new object when none is free
+     */
+    explicit Pool(std::function<std::unique_ptr<T>()> factory): shared{std::make_shared<Shared>()} {
+        shared->factory = std::move(factory);
+    }
+
+    /**
+     * @return A free object, a new one if every object is in use
+     */
+    std::shared_ptr<T> acquire() {
+        std::unique_ptr<T> object;
+        {
+            std::lock_guard<std::mutex> lock{shared->mutex};
+            if(not shared->free.empty()) {
+                object = std::move(shared->free.back());
+                shared->free.pop_back();
+            }
+            else {
+                shared->created++;
+            }
+        }
+        if(not object) {
+            object = shared->factory();
+        }
+
+        auto owner = shared;
+        return std::shared_ptr<T>(object.release(), [owner](T* released) {
+            std::lock_guard<std::mutex> lock{owner->mutex};
+            owner->free.emplace_back(released);
+        });
+    }
+
+    /**
+     * @return The number of objects created so far
+     */
+    std::size_t created() const {
+        std::lock_guard<std::mutex> lock{shared->mutex};
+        return shared->created;
+    }
+
+private:
+    class Shared {
+    public:
+        std::mutex mutex;
+        std::vector<std::unique_ptr<T>> free;
+        std::function<std::unique_ptr<T>()> factory;
+        std::size_t created = 0;
+    };
+
+    std::shared_ptr<Shared> shared;
+};
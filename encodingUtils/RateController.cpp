@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include "RateController.hpp"
+
+using namespace std;
+
+// share of the intra complexity P and B frames start with, before the first frame of their type is measured
+static const double INITIAL_COMPLEXITY_RATIO[3] = {1.0, 0.5, 0.35};
+
+// range of the measured model exponents
+static const double MIN_EXPONENT = 0.05;
+static const double MAX_EXPONENT = 2.0;
+
+// row rate control may move the quantizer this far from the frame quantizer
+static const int ROW_QUANTIZER_RANGE = 4;
+
+/**
+ * @return The number of bits of the magnitude of a value, 0 for 0
+ */
+static int magnitudeBits(int value) {
+    value = abs(value);
+    return value == 0 ? 0 : 32 - __builtin_clz(static_cast<unsigned>(value));
+}
+
+/**
+ * @return The length of the signed Exp-Golomb code of a value
+ */
+static int expGolombBits(int value) {
+    unsigned mapped = value > 0 ? 2 * value - 1 : -2 * value;
+    return 2 * magnitudeBits(static_cast<int>(mapped + 1)) - 1;
+}
+
+RateController::RateController(const EncoderSettings& settings): settings{settings} {
+    bitsPerFrame = static_cast<long long>(settings.targetBitrate) / max(1, settings.frameRate);
+    bufferSize = settings.vbvBufferSize > 0 ? settings.vbvBufferSize : settings.targetBitrate;
+    // start almost full, like a decoder that waited for the buffer before playing
+    fullness = bufferSize * 9 / 10;
+    quantizer = currentQuantizer = settings.quantizer;
+}
+
+int RateController::clampQuantizer(int value) const {
+    return max(settings.minQuantizer, min(settings.maxQuantizer, value));
+}
+
+long long RateController::frameTarget() const {
+    long long output;
+    if(settings.rateControl == CONSTANT_BITRATE) {
+        // steer the buffer back to half full within about a quarter second
+        output = bitsPerFrame + (fullness - bufferSize / 2) / max(1, settings.frameRate / 4);
+    }
+    else {
+        // spread the difference to the average bitrate so far over about a second
+        output = bitsPerFrame + (bitsPerFrame * framesCoded - bitsCoded) / max(1, settings.frameRate);
+    }
+
+    // the frame must fit in the buffer once the bits of its frame period arrived
+    long long available = min(bufferSize, fullness + bitsPerFrame);
+    return max(bitsPerFrame / 8, min(output, available));
+}
+
+long long RateController::intraComplexity(const Frame& frame) {
+    // bits of coding every sample against the flat intra prediction at quantizer 1, as frameBits counts them
+    long long bits = 0;
+    for(auto plane : {&frame.y, &frame.cb, &frame.cr}) {
+        for(int i=0; i<plane->height; i++) {
+            auto row = plane->row(i);
+            for(int j=0; j<plane->width; j++) {
+                int size = magnitudeBits(row[j] - 128);
+                bits += size == 0 ? 0 : 8 + size;
+            }
+        }
+    }
+    return bits;
+}
+
+int RateController::frameQuantizer(FrameType type, const Frame& frame) {
+    rows = frame.height() / 8;
+    if(settings.rateControl == CONSTANT_QUALITY) {
+        quantizer = currentQuantizer = settings.quantizer;
+        return quantizer;
+    }
+
+    if(complexity[type] == 0) {
+        if(complexity[I_FRAME] == 0) {
+            complexity[I_FRAME] = static_cast<double>(intraComplexity(frame));
+        }
+        complexity[type] = complexity[I_FRAME] * INITIAL_COMPLEXITY_RATIO[type];
+    }
+
+    target = frameTarget();
+    double ratio = complexity[type] / static_cast<double>(max(1LL, target));
+    int modelQuantizer = static_cast<int>(ceil(pow(max(1.0, ratio), 1 / exponent[type])));
+    if(framesCoded > 0) {
+        // the model is rough, move at most a quarter from the previous frame so quality stays smooth
+        int step = max(1, previousQuantizer / 4);
+        modelQuantizer = max(previousQuantizer - step, min(previousQuantizer + step, modelQuantizer));
+    }
+    quantizer = clampQuantizer(modelQuantizer);
+    currentQuantizer = quantizer;
+    return quantizer;
+}
+
+int RateController::rowQuantizer(int row, long long bits) {
+    if(settings.rateControl == CONSTANT_QUALITY || not settings.rowRateControl) {
+        return currentQuantizer;
+    }
+
+    // compare with the share of the target of the rows so far, allowing 10% either way
+    long long expected = target * row / max(1, rows);
+    if(bits > expected + expected / 10) {
+        currentQuantizer++;
+    }
+    else if(bits < expected - expected / 10) {
+        currentQuantizer--;
+    }
+    currentQuantizer = clampQuantizer(max(quantizer - ROW_QUANTIZER_RANGE,
+                                          min(quantizer + ROW_QUANTIZER_RANGE, currentQuantizer)));
+    return currentQuantizer;
+}
+
+void RateController::update(const EncodedFrame& frame) {
+    long long bits = frameBits(frame);
+    framesCoded++;
+    bitsCoded += bits;
+
+    fullness = max(0LL, min(bufferSize, fullness + bitsPerFrame) - bits);
+
+    double meanQuantizer = frame.quantizer;
+    if(not frame.rowQuantizers.empty()) {
+        long long sum = 0;
+        for(int rowQuantizer : frame.rowQuantizers) {
+            sum += rowQuantizer;
+        }
+        meanQuantizer = static_cast<double>(sum) / static_cast<double>(frame.rowQuantizers.size());
+    }
+    bits = max(1LL, bits);
+    auto type = frame.type;
+    if(lastBits[type] != 0 && abs(meanQuantizer - lastQuantizer[type]) >= 1) {
+        // the slope of log(bits) over log(quantizer), smoothed since the content changes between frames as well
+        double measured = log(static_cast<double>(lastBits[type]) / static_cast<double>(bits))
+                        / log(meanQuantizer / lastQuantizer[type]);
+        exponent[type] = (exponent[type] + max(MIN_EXPONENT, min(MAX_EXPONENT, measured))) / 2;
+    }
+    previousQuantizer = static_cast<int>(lround(meanQuantizer));
+    lastBits[type] = bits;
+    lastQuantizer[type] = meanQuantizer;
+    complexity[type] = static_cast<double>(bits) * pow(meanQuantizer, exponent[type]);
+}
+
+long long RateController::coefficientBits(const ACCoefficient* first, const ACCoefficient* last) {
+    long long bits = 0;
+    for(auto coefficient = first; coefficient != last; coefficient++) {
+        bits += 8 + magnitudeBits(coefficient->dcCoefficient.amplitude);
+    }
+    return bits;
+}
+
+long long RateController::frameBits(const EncodedFrame& frame) {
+    long long bits = coefficientBits(frame.coefficients.data(), frame.coefficients.data() + frame.coefficients.size());
+    bits += static_cast<long long>(frame.skipFlags.size()) + 2 * static_cast<long long>(frame.directions.size());
+    for(auto vectors : {&frame.motionVectors, &frame.backwardVectors}) {
+        for(auto& mv : *vectors) {
+            bits += expGolombBits(mv.dx) + expGolombBits(mv.dy);
+        }
+    }
+    return bits;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "EncodedFrame.hpp"
+#include "EncoderSettings.hpp"
+#include "Frame.hpp"
+
+/**
+ * Chooses the quantizer of every frame, and optionally of every block row, for the rate control mode of the
+ * settings.
+ *
+ * Frame sizes follow the model bits = complexity * quantizer ^ -exponent. Most of the bits of a coefficient do not
+ * depend on the quantizer, so the exponent is well below 1. The complexity of each frame type is measured on the
+ * last frame of that type, the exponent on the last two frames of that type coded with different quantizers.
+ * Before the first frame, the intra complexity is estimated from the samples. P and B frames start from a fixed
+ * share of it. The quantizer moves by at most a quarter from one frame to the next. The bits of a frame are
+ * estimated from its symbols, see frameBits.
+ *
+ * The VBV buffer is the decoder buffer. It fills at the target bitrate and empties by the size of every frame.
+ */
+class RateController {
+public:
+    explicit RateController(const EncoderSettings& settings);
+
+    /**
+     * Start a frame
+     * @param type The type of the frame
+     * @param frame The source frame, used for the first complexity estimate
+     * @return The quantizer of the frame
+     */
+    int frameQuantizer(FrameType type, const Frame& frame);
+
+    /**
+     * Quantizer of the next block row of the current frame
+     * @param row The block row, from 1
+     * @param bits The bits produced by the rows before it
+     * @return The quantizer of the row, the frame quantizer unless row rate control is enabled
+     */
+    int rowQuantizer(int row, long long bits);
+
+    /**
+     * Account for a frame once it is encoded
+     */
+    void update(const EncodedFrame& frame);
+
+    /**
+     * Change the quantizers of the settings, e.g. for a real time speed level. The model of every frame type is kept.
+     * @param quantizer The quantizer of every frame in CONSTANT_QUALITY mode
+     * @param minQuantizer The finest quantizer of the bitrate modes
+     */
+    void setQuantizers(int quantizer, int minQuantizer) {
+        settings.quantizer = quantizer;
+        settings.minQuantizer = minQuantizer;
+    }
+
+    /**
+     * @return The bits in the VBV buffer
+     */
+    long long bufferFullness() const {
+        return fullness;
+    }
+
+    /**
+     * @return The estimated size in bits of a frame: a (run length, size) code of 8 bits plus the amplitude bits for
+     *         every coefficient, 1 bit per skip flag, 2 bits per prediction direction and signed Exp-Golomb codes for
+     *         the motion vectors
+     */
+    static long long frameBits(const EncodedFrame& frame);
+
+    /**
+     * @return The estimated size in bits of a range of coefficients
+     */
+    static long long coefficientBits(const ACCoefficient* first, const ACCoefficient* last);
+
+private:
+    int clampQuantizer(int quantizer) const;
+    long long frameTarget() const;
+    static long long intraComplexity(const Frame& frame);
+
+    EncoderSettings settings;
+    long long bitsPerFrame = 0;
+    long long bufferSize = 0;
+    long long fullness = 0;
+
+    long long framesCoded = 0;
+    long long bitsCoded = 0;
+    // model of each frame type
+    double complexity[3] = {0, 0, 0};
+    double exponent[3] = {0.3, 0.3, 0.3};
+    double lastQuantizer[3] = {0, 0, 0};
+    long long lastBits[3] = {0, 0, 0};
+    int previousQuantizer = 1;
+
+    // current frame
+    long long target = 0;
+    int rows = 0;
+    int quantizer = 1;
+    int currentQuantizer = 1;
+};
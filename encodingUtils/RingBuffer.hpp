@@ -0,0 +1,430 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * How a ring buffer waits for a free slot or an item.
+ * SPIN_WAIT keeps the thread running, for handoffs measured in nanoseconds on threads that have a core of their own.
+ * BLOCK_WAIT spins for a short while and then sleeps until the other side makes progress.
+ */
+enum WaitMode {SPIN_WAIT, BLOCK_WAIT};
+
+/**
+ * Lets the threads waiting on a ring buffer sleep.
+ *
+ * The buffer itself needs no lock, the mutex only guards sleeping: a thread that made progress only takes it when
+ * somebody sleeps, which it finds out with a single load.
+ */
+class RingWaiter {
+public:
+    /**
+     * Sleep until ready() returns true, ready() is checked again after every notify()
+     */
+    template<class Ready>
+    void wait(Ready ready) {
+        std::unique_lock<std::mutex> lock{mutex};
+        sleepers.fetch_add(1);
+        // the buffer is checked after announcing the sleeper, notify() publishes before looking for sleepers
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        condition.wait(lock, ready);
+        sleepers.fetch_sub(1);
+    }
+
+    /**
+     * Wake the sleeping threads, if there are any
+     */
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(sleepers.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock{mutex};
+            condition.notify_all();
+        }
+    }
+
+private:
+    std::atomic<int> sleepers{0};
+    std::mutex mutex;
+    std::condition_variable condition;
+};
+
+/**
+ * The waiting and closing shared by SpscRing and MpmcRing
+ */
+class RingState {
+public:
+    static constexpr std::size_t CACHE_LINE = 64;
+    static constexpr int SPIN_LIMIT = 128;     // attempts before a BLOCK_WAIT thread sleeps
+
+    explicit RingState(WaitMode mode): mode{mode} {};
+
+    /**
+     * Repeat a push attempt until it succeeds or the ring is closed
+     * @param waiter Where to sleep in BLOCK_WAIT mode
+     * @return false if the ring was closed before attempt() succeeded, nothing is pushed after close()
+     */
+    template<class Attempt>
+    bool waitForSlot(RingWaiter& waiter, Attempt attempt) {
+        return wait(waiter, false, attempt);
+    }
+
+    /**
+     * Repeat a pop attempt until it succeeds or the ring is closed and empty
+     * @param waiter Where to sleep in BLOCK_WAIT mode
+     * @return false if the ring was closed and attempt() found it empty
+     */
+    template<class Attempt>
+    bool waitForItem(RingWaiter& waiter, Attempt attempt) {
+        return wait(waiter, true, attempt);
+    }
+
+    /**
+     * Wake the threads waiting in waiter after a successful push or pop
+     */
+    void notify(RingWaiter& waiter) {
+        if(mode == BLOCK_WAIT) {
+            waiter.notify();
+        }
+    }
+
+    void close() {
+        closed.store(true);
+        notEmpty.notify();
+        notFull.notify();
+    }
+
+    WaitMode mode;
+    RingWaiter notEmpty;    // consumers sleep here
+    RingWaiter notFull;     // producers sleep here
+
+private:
+    /**
+     * @param drain Whether attempt() still runs once the ring is closed, for the pops of the items left
+     */
+    template<class Attempt>
+    bool wait(RingWaiter& waiter, bool drain, Attempt attempt) {
+        for(int spin=0; mode == SPIN_WAIT || spin < SPIN_LIMIT; spin++) {
+            // closed is read first: everything pushed before close() is visible to the attempt after it
+            bool wasClosed = closed.load(std::memory_order_acquire);
+            if(wasClosed && not drain) {
+                return false;
+            }
+            if(attempt()) {
+                return true;
+            }
+            if(wasClosed) {
+                return false;
+            }
+            relax(spin);
+        }
+
+        bool done = false;
+        waiter.wait([&]() {
+            bool wasClosed = closed.load(std::memory_order_acquire);
+            if(drain || not wasClosed) {
+                done = attempt();
+            }
+            return done || wasClosed;
+        });
+        return done;
+    }
+
+    static void relax(int spin) {
+        if(spin % 64 != 63) {
+#ifdef __SSE2__
+            _mm_pause();
+#endif
+        }
+        else {
+            // give the core away now and then, the other side may be waiting for it
+            std::this_thread::yield();
+        }
+    }
+
+    std::atomic<bool> closed{false};
+};
+
+/**
+ * @return The smallest power of two that is at least capacity
+ */
+inline std::size_t ringCapacity(std::size_t capacity) {
+    std::size_t size = 1;
+    while(size < capacity) {
+        size *= 2;
+    }
+    return size;
+}
+
+/**
+ * A lock-free first in, first out ring buffer between one producer thread and one consumer thread.
+ *
+ * The read and write positions live on cache lines of their own, next to a copy of the other side's position, so a
+ * push or pop only touches the other side's cache line when the ring looks full or empty.
+ * The capacity is rounded up to a power of two. push() waits while the ring is full and pop() while it is empty, the
+ * way selected by the WaitMode. After close() the items left can still be popped, then pop() reports the end.
+ */
+template<class T>
+class SpscRing {
+public:
+    explicit SpscRing(std::size_t capacity, WaitMode mode = BLOCK_WAIT):
+            state{mode}, mask{ringCapacity(capacity) - 1}, slots{new T[mask + 1]} {};
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    std::size_t capacity() const {
+        return mask + 1;
+    }
+
+    /**
+     * Append an item if there is a free slot, item is left alone otherwise
+     */
+    bool tryPush(T&& item) {
+        if(not pushSlot(item)) {
+            return false;
+        }
+        state.notify(state.notEmpty);
+        return true;
+    }
+
+    /**
+     * Take the oldest item if there is one
+     */
+    bool tryPop(T& item) {
+        if(not popSlot(item)) {
+            return false;
+        }
+        state.notify(state.notFull);
+        return true;
+    }
+
+    /**
+     * Append an item, waiting for a free slot
+     * @return false if the ring was closed, the item is dropped
+     */
+    bool push(T item) {
+        if(not state.waitForSlot(state.notFull, [&]() {
+            return pushSlot(item);
+        })) {
+            return false;
+        }
+        state.notify(state.notEmpty);
+        return true;
+    }
+
+    /**
+     * Take the oldest item, waiting for one
+     * @return false if the ring is closed and empty
+     */
+    bool pop(T& item) {
+        if(not state.waitForItem(state.notEmpty, [&]() {
+            return popSlot(item);
+        })) {
+            return false;
+        }
+        state.notify(state.notFull);
+        return true;
+    }
+
+    /**
+     * End the ring, waking every waiting thread. Called by the producer after its last push.
+     */
+    void close() {
+        state.close();
+    }
+
+private:
+    bool pushSlot(T& item) {
+        std::size_t position = tail.load(std::memory_order_relaxed);
+        if(position - cachedHead > mask) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if(position - cachedHead > mask) {
+                return false;
+            }
+        }
+        slots[position & mask] = std::move(item);
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool popSlot(T& item) {
+        std::size_t position = head.load(std::memory_order_relaxed);
+        if(position == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if(position == cachedTail) {
+                return false;
+            }
+        }
+        item = std::move(slots[position & mask]);
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    RingState state;
+    const std::size_t mask;
+    const std::unique_ptr<T[]> slots;
+
+    // consumer side: the next position to read and the last write position it saw
+    alignas(RingState::CACHE_LINE) std::atomic<std::size_t> head{0};
+    std::size_t cachedTail = 0;
+
+    // producer side: the next position to write and the last read position it saw
+    alignas(RingState::CACHE_LINE) std::atomic<std::size_t> tail{0};
+    std::size_t cachedHead = 0;
+};
+
+/**
+ * A lock-free first in, first out ring buffer between any number of producer and consumer threads.
+ *
+ * Every slot carries a sequence number telling whether it is free for the push of a position or holds the item for
+ * the pop of a position. Producers and consumers claim positions with a compare and swap on their own cache line and
+ * never wait for each other inside a push or pop.
+ * The capacity is rounded up to a power of two. push() waits while the ring is full and pop() while it is empty, the
+ * way selected by the WaitMode. close() is called once every producer is done, the items left can still be popped,
+ * then pop() reports the end.
+ */
+template<class T>
+class MpmcRing {
+public:
+    explicit MpmcRing(std::size_t capacity, WaitMode mode = BLOCK_WAIT):
+            state{mode}, mask{ringCapacity(capacity) - 1}, slots{new Slot[mask + 1]} {
+        for(std::size_t i=0; i<=mask; i++) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    };
+
+    MpmcRing(const MpmcRing&) = delete;
+    MpmcRing& operator=(const MpmcRing&) = delete;
+
+    std::size_t capacity() const {
+        return mask + 1;
+    }
+
+    /**
+     * Append an item if there is a free slot, item is left alone otherwise
+     */
+    bool tryPush(T&& item) {
+        if(not pushSlot(item)) {
+            return false;
+        }
+        state.notify(state.notEmpty);
+        return true;
+    }
+
+    /**
+     * Take the oldest item if there is one
+     */
+    bool tryPop(T& item) {
+        if(not popSlot(item)) {
+            return false;
+        }
+        state.notify(state.notFull);
+        return true;
+    }
+
+    /**
+     * Append an item, waiting for a free slot
+     * @return false if the ring was closed, the item is dropped
+     */
+    bool push(T item) {
+        if(not state.waitForSlot(state.notFull, [&]() {
+            return pushSlot(item);
+        })) {
+            return false;
+        }
+        state.notify(state.notEmpty);
+        return true;
+    }
+
+    /**
+     * Take the oldest item, waiting for one
+     * @return false if the ring is closed and empty
+     */
+    bool pop(T& item) {
+        if(not state.waitForItem(state.notEmpty, [&]() {
+            return popSlot(item);
+        })) {
+            return false;
+        }
+        state.notify(state.notFull);
+        return true;
+    }
+
+    /**
+     * End the ring, waking every waiting thread. Called after the last push of every producer.
+     */
+    void close() {
+        state.close();
+    }
+
+private:
+    class Slot {
+    public:
+        // position + 1 once the item of position is in, position + capacity once it is out
+        std::atomic<std::size_t> sequence;
+        T item;
+    };
+
+    bool pushSlot(T& item) {
+        std::size_t position = tail.load(std::memory_order_relaxed);
+        Slot* slot;
+        while(true) {
+            slot = &slots[position & mask];
+            auto difference = static_cast<std::intptr_t>(slot->sequence.load(std::memory_order_acquire) - position);
+            if(difference == 0) {
+                if(tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if(difference < 0) {
+                // the item of the previous round is still in the slot
+                return false;
+            }
+            else {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+        slot->item = std::move(item);
+        slot->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool popSlot(T& item) {
+        std::size_t position = head.load(std::memory_order_relaxed);
+        Slot* slot;
+        while(true) {
+            slot = &slots[position & mask];
+            auto difference = static_cast<std::intptr_t>(slot->sequence.load(std::memory_order_acquire) - (position + 1));
+            if(difference == 0) {
+                if(head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if(difference < 0) {
+                // the item of this position is not in yet
+                return false;
+            }
+            else {
+                position = head.load(std::memory_order_relaxed);
+            }
+        }
+        item = std::move(slot->item);
+        slot->sequence.store(position + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    RingState state;
+    const std::size_t mask;
+    const std::unique_ptr<Slot[]> slots;
+
+    alignas(RingState::CACHE_LINE) std::atomic<std::size_t> head{0};     // the next position to pop
+    alignas(RingState::CACHE_LINE) std::atomic<std::size_t> tail{0};     // the next position to push
+};
@@ -0,0 +1,42 @@
+#include <cstdlib>
+#include "RunLengthCoder.hpp"
+
+using namespace std;
+
+void RunLengthCoder::encodeBlock(const Block& block) {
+    for(const auto& coef : block.entropy_encode()) {
+        auto amplitude = static_cast<uint16_t>(coef.dcCoefficient.amplitude);
+
+        bytes.push_back(static_cast<unsigned char>(coef.runlength));
+        bytes.push_back(static_cast<unsigned char>(amplitude & 0xFF));
+        bytes.push_back(static_cast<unsigned char>(amplitude >> 8));
+    }
+}
+
+std::vector<unsigned char> RunLengthCoder::finish() {
+    vector<unsigned char> output;
+    output.swap(bytes);
+    return output;
+}
+
+void RunLengthCoder::startDecoding(const unsigned char* data, size_t size) {
+    // parse the pairs up front, the EntropyDecoder finds the block boundaries
+    coefficients.clear();
+    coefficients.reserve(size / 3);
+    for(size_t i=0; i + 2 < size; i+=3) {
+        int runlength = data[i];
+        auto amplitude = static_cast<int16_t>(data[i + 1] | (data[i + 2] << 8));
+        if(runlength > 63 || abs(amplitude) > DCCoefficient::MAX_AMPLITUDE) {
+            // a damaged pair, stop here so the block holding it fails to decode
+            break;
+        }
+        coefficients.emplace_back(runlength, DCCoefficient(amplitude));
+    }
+
+    decoder = EntropyDecoder{coefficients};
+}
+
+bool RunLengthCoder::decodeBlock(BlockType, std::vector<int>& zigZagValues) {
+    // the pairs of every block type share one scheme
+    return decoder.decodeNext(zigZagValues);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "EntropyCoder.hpp"
+#include "EntropyDecoder.hpp"
+
+/**
+ * EntropyCoder over the run-length scheme of Block::entropy_encode.
+ * Each (run length, amplitude) pair is stored as one run length byte followed by the amplitude as a 16 bit
+ * little endian value. Decoding stops at the first pair with a run over 63 or an amplitude out of the DCCoefficient
+ * range, so the block holding it fails to decode.
+ */
+class RunLengthCoder : public EntropyCoder {
+public:
+    void encodeBlock(const Block& block) override;
+    std::vector<unsigned char> finish() override;
+
+    void startDecoding(const unsigned char* data, size_t size) override;
+    bool decodeBlock(BlockType type, std::vector<int>& zigZagValues) override;
+
+private:
+    std::vector<unsigned char> bytes;
+
+    std::vector<ACCoefficient> coefficients;
+    EntropyDecoder decoder;
+};
@@ -0,0 +1,42 @@
+#include <cstdlib>
+#include "SceneDetector.hpp"
+
+using namespace std;
+
+void SceneDetector::downscale(const Plane& luma, std::vector<int>& output) const {
+    int blocksPerRow = luma.width / 8;
+    output.assign(static_cast<size_t>(blocksPerRow) * (luma.height / 8), 0);
+
+    // sum the rows of every block strip, then divide once
+    for(int top=0; top<luma.height / 8 * 8; top+=8) {
+        int* sums = output.data() + static_cast<size_t>(top / 8) * blocksPerRow;
+        for(int i=0; i<8; i++) {
+            auto row = luma.row(top + i);
+            for(int block=0; block<blocksPerRow; block++) {
+                for(int j=0; j<8; j++) {
+                    sums[block] += row[block * 8 + j];
+                }
+            }
+        }
+        for(int block=0; block<blocksPerRow; block++) {
+            sums[block] >>= 6;
+        }
+    }
+}
+
+bool SceneDetector::isSceneChange(const Frame& frame) {
+    downscale(frame.y, current);
+
+    bool comparable = previous.size() == current.size() && not current.empty();
+    difference = 0;
+    if(comparable) {
+        long long total = 0;
+        for(size_t i=0; i<current.size(); i++) {
+            total += abs(current[i] - previous[i]);
+        }
+        difference = static_cast<int>(total / static_cast<long long>(current.size()));
+    }
+
+    swap(previous, current);
+    return comparable && difference >= threshold;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+
+#include "Frame.hpp"
+
+/**
+ * Detects hard cuts between consecutive frames. Every frame is reduced to the average luma of its 8x8 blocks, a cut
+ * is a large mean absolute difference between the reduced frame and the one before it. Small motion barely changes
+ * the averages, a new scene changes most of them.
+ */
+class SceneDetector {
+public:
+    /**
+     * @param threshold Smallest mean absolute difference of the block averages that counts as a cut
+     */
+    explicit SceneDetector(int threshold): threshold{threshold} {};
+
+    int threshold;
+
+    /**
+     * Analyse the next frame of the sequence
+     * @return Whether the frame starts a new scene, never for the first frame
+     */
+    bool isSceneChange(const Frame& frame);
+
+    /**
+     * @return The mean absolute difference of the block averages computed by the last isSceneChange call
+     */
+    int lastDifference() const {
+        return difference;
+    }
+
+private:
+    void downscale(const Plane& luma, std::vector<int>& output) const;
+
+    std::vector<int> previous;
+    std::vector<int> current;
+    int difference = 0;
+};
@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <stdexcept>
+#include "SegmentedStream.hpp"
+#include "EntropyDecoder.hpp"
+
+using namespace std;
+
+int SegmentedStream::RESTART_MARKER = -1;
+
+void SegmentedStream::encodeSegment(const tuple<vector<Block>, vector<Block>, vector<Block>>& blocks, int segment,
+                                    int first, int last, vector<ACCoefficient>& output) {
+    // restart point: emit the marker, the DC prediction per component starts over
+    output.emplace_back(RESTART_MARKER, DCCoefficient(segment));
+    int predictors[3] = {0, 0, 0};
+
+    for(int i=first; i<last; i++) {
+        const Block* sources[3] = {&get<0>(blocks)[i], &get<1>(blocks)[i], &get<2>(blocks)[i]};
+        for(int c=0; c<3; c++) {
+            // skip the DCT part, expand to 8x8
+            auto expanded = sources[c]->expandTo8x8();
+            auto encoded = expanded->entropy_encode();
+            delete expanded;
+
+            // code the DC value as the difference to the previous block of the same component
+            int dc = encoded[0].dcCoefficient.amplitude;
+            encoded[0].dcCoefficient = DCCoefficient(dc - predictors[c]);
+            predictors[c] = dc;
+
+            output.insert(output.end(), encoded.begin(), encoded.end());
+        }
+    }
+}
+
+SegmentedStream SegmentedStream::encode(const tuple<vector<Block>, vector<Block>, vector<Block>>& blocks,
+                                        int blocksPerRow, int restartInterval) {
+    SegmentedStream output;
+    output.blockCount = static_cast<int>(get<0>(blocks).size());
+    output.blocksPerSegment = blocksPerRow * restartInterval;
+
+    for(int first=0, segment=0; first<output.blockCount; first+=output.blocksPerSegment, segment++) {
+        output.segmentOffsets.push_back(output.coefficients.size());
+        encodeSegment(blocks, segment, first, min(first + output.blocksPerSegment, output.blockCount),
+                      output.coefficients);
+    }
+
+    return output;
+}
+
+SegmentedStream SegmentedStream::encode(const tuple<vector<Block>, vector<Block>, vector<Block>>& blocks,
+                                        int blocksPerRow, int restartInterval, ThreadPool& pool) {
+    SegmentedStream output;
+    output.blockCount = static_cast<int>(get<0>(blocks).size());
+    output.blocksPerSegment = blocksPerRow * restartInterval;
+
+    // every segment is coded into its own buffer, the buffers are joined in order
+    int segmentCount = (output.blockCount + output.blocksPerSegment - 1) / output.blocksPerSegment;
+    vector<vector<ACCoefficient>> segments(segmentCount);
+    pool.parallelFor(segmentCount, [&](size_t segment) {
+        int first = static_cast<int>(segment) * output.blocksPerSegment;
+        encodeSegment(blocks, static_cast<int>(segment), first, min(first + output.blocksPerSegment, output.blockCount),
+                      segments[segment]);
+    });
+
+    size_t total = 0;
+    for(const auto& segment : segments) {
+        total += segment.size();
+    }
+    output.coefficients.reserve(total);
+    for(const auto& segment : segments) {
+        output.segmentOffsets.push_back(output.coefficients.size());
+        output.coefficients.insert(output.coefficients.end(), segment.begin(), segment.end());
+    }
+
+    return output;
+}
+
+bool SegmentedStream::decodeSegment(size_t segment, vector<Block*>& Y, vector<Block*>& U, vector<Block*>& V) const {
+    size_t start = segmentOffsets[segment];
+    size_t end = segment + 1 < segmentOffsets.size() ? segmentOffsets[segment + 1] : coefficients.size();
+
+    if(start >= end || end > coefficients.size() || coefficients[start].runlength != RESTART_MARKER
+       || coefficients[start].dcCoefficient.amplitude != static_cast<int>(segment)) {
+        return false;
+    }
+
+    // skip the marker, the decoder only sees this segment's coefficients
+    EntropyDecoder decoder{coefficients.data() + start + 1, end - start - 1};
+    vector<int> zigZagValues;
+    int predictors[3] = {0, 0, 0};
+    vector<Block*>* outputs[3] = {&Y, &U, &V};
+    const BlockType types[3] = {BlockType::Y, BlockType::U, BlockType::V};
+
+    int blockIdx = static_cast<int>(segment) * blocksPerSegment;
+    int lastIdx = min(blockIdx + blocksPerSegment, blockCount);
+    while(not decoder.exhausted()) {
+        if(blockIdx >= lastIdx) {
+            // more blocks than the segment holds
+            return false;
+        }
+        for(int c=0; c<3; c++) {
+            if(not decoder.decodeNext(zigZagValues)) {
+                return false;
+            }
+
+            zigZagValues[0] += predictors[c];
+            predictors[c] = zigZagValues[0];
+
+            auto block = new Block(Block::zigZagReverse(zigZagValues));
+            block->setType(types[c]);
+            (*outputs[c])[blockIdx] = block;
+        }
+        blockIdx++;
+    }
+    return blockIdx == lastIdx;
+}
+
+void SegmentedStream::checkDecoded(const vector<char>& decoded,
+                                   tuple<vector<Block*>, vector<Block*>, vector<Block*>>& blocks) {
+    auto damaged = find(decoded.begin(), decoded.end(), 0);
+    if(damaged == decoded.end()) {
+        return;
+    }
+
+    for(auto component : {&get<0>(blocks), &get<1>(blocks), &get<2>(blocks)}) {
+        for(auto block : *component) {
+            delete block;
+        }
+    }
+    throw runtime_error("corrupt segment " + to_string(damaged - decoded.begin()));
+}
+
+tuple<vector<Block*>, vector<Block*>, vector<Block*>> SegmentedStream::decode(ThreadPool& pool) const {
+    vector<Block*> Y(blockCount), U(blockCount), V(blockCount);
+    vector<char> decoded(segmentOffsets.size());
+
+    // each segment writes a disjoint range of blocks
+    pool.parallelFor(segmentOffsets.size(), [&](size_t segment) {
+        decoded[segment] = decodeSegment(segment, Y, U, V);
+    });
+
+    auto output = make_tuple(move(Y), move(U), move(V));
+    checkDecoded(decoded, output);
+    return output;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <tuple>
+#include <vector>
+
+#include "AcCoefficient.hpp"
+#include "Block.hpp"
+#include "ThreadPool.hpp"
+
+/**
+ * Coefficient stream of a frame split into independently decodable segments.
+ *
+ * A segment holds restartInterval block rows. Every segment starts with a restart marker and resets the DC
+ * prediction, so segments can be decoded in any order and on separate threads.
+ */
+class SegmentedStream {
+public:
+    static int RESTART_MARKER;
+
+    std::vector<ACCoefficient> coefficients;
+    std::vector<size_t> segmentOffsets;    // index of the restart marker of each segment in coefficients
+    int blocksPerSegment = 0;               // number of (Y, Cb, Cr) block triplets in a full segment
+    int blockCount = 0;
+
+    /**
+     * Entropy-encode the blocks of a frame. Blocks are interleaved Y, Cb, Cr as in the unsegmented stream.
+     * @param blocks The Y, U and V blocks of the frame, U and V still 4x4
+     * @param blocksPerRow The number of blocks in a block row of the frame
+     * @param restartInterval The number of block rows per segment
+     */
+    static SegmentedStream encode(const std::tuple<std::vector<Block>, std::vector<Block>, std::vector<Block>>& blocks,
+                                  int blocksPerRow, int restartInterval);
+
+    /**
+     * Entropy-encode the segments of a frame on the threads of a pool. The stream is the same as the one of the
+     * single threaded encode.
+     */
+    static SegmentedStream encode(const std::tuple<std::vector<Block>, std::vector<Block>, std::vector<Block>>& blocks,
+                                  int blocksPerRow, int restartInterval, ThreadPool& pool);
+
+    /**
+     * Decode all segments on the threads of a pool
+     * @return The 8x8 Y, Cb and Cr blocks in frame order, with their types set
+     * @throw runtime_error if a segment is truncated or corrupt, no blocks are returned then
+     */
+    std::tuple<std::vector<Block*>, std::vector<Block*>, std::vector<Block*>> decode(ThreadPool& pool) const;
+
+private:
+    static void encodeSegment(const std::tuple<std::vector<Block>, std::vector<Block>, std::vector<Block>>& blocks,
+                              int segment, int first, int last, std::vector<ACCoefficient>& output);
+    // false if the segment is truncated or corrupt, the blocks decoded so far are kept
+    bool decodeSegment(size_t segment, std::vector<Block*>& Y, std::vector<Block*>& U, std::vector<Block*>& V) const;
+    // free the blocks and throw if a segment failed to decode
+    static void checkDecoded(const std::vector<char>& decoded,
+                             std::tuple<std::vector<Block*>, std::vector<Block*>, std::vector<Block*>>& blocks);
+};
@@ -0,0 +1,71 @@
+#include <algorithm>
+#include "SpeedController.hpp"
+
+using namespace std;
+
+// weight of the latest frame in the average encode time
+static const double SMOOTHING = 0.25;
+
+SpeedController::SpeedController(const EncoderSettings& settings): base{settings} {
+    interval = 1.0 / max(1, settings.frameRate);
+}
+
+bool SpeedController::update(double seconds) {
+    bool missed = seconds > interval;
+    if(missed) {
+        misses++;
+    }
+    averageSeconds = framesAtLevel == 0 ? seconds : averageSeconds + (seconds - averageSeconds) * SMOOTHING;
+    framesAtLevel++;
+
+    int next = currentLevel;
+    if(missed) {
+        // a miss starts the count of calm frames over, whether or not it is enough to step up
+        calmFrames = 0;
+        if(averageSeconds > interval || seconds > 2 * interval) {
+            next = min(LEVEL_COUNT - 1, currentLevel + 1);
+        }
+    }
+    else if(averageSeconds < HEADROOM * interval) {
+        // step back only after a while, a single fast frame says little
+        if(++calmFrames >= CALM_FRAMES) {
+            next = max(0, currentLevel - 1);
+        }
+    }
+    else {
+        calmFrames = 0;
+    }
+
+    if(next == currentLevel) {
+        return false;
+    }
+    // the average of the old level says nothing about the new one
+    currentLevel = next;
+    framesAtLevel = 0;
+    calmFrames = 0;
+    return true;
+}
+
+EncoderSettings SpeedController::settings() const {
+    EncoderSettings output = base;
+    if(currentLevel >= 1) {
+        output.subpelRefinement = min(output.subpelRefinement, 1);
+    }
+    if(currentLevel >= 2) {
+        output.subpelRefinement = 0;
+        output.searchRange = min(output.searchRange, 8);
+    }
+    if(currentLevel >= 3) {
+        // B frames need two searches and a choice between three predictions per block
+        output.searchRange = min(output.searchRange, 4);
+        output.bFrames = 0;
+        if(output.skipThreshold > 0) {
+            output.skipThreshold *= 2;
+        }
+    }
+    if(currentLevel >= 4) {
+        output.quantizer = min(output.maxQuantizer, output.quantizer + 2);
+        output.minQuantizer = min(output.maxQuantizer, output.minQuantizer + 2);
+    }
+    return output;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "EncoderSettings.hpp"
+
+/**
+ * Keeps a real time encoder up with its input by trading quality for speed.
+ *
+ * Every frame has the frame interval of the frame rate to be encoded in. The encode time of every frame is averaged
+ * over the frames coded at the current speed level. A frame that misses its deadline while the average is over the
+ * interval, or takes more than twice the interval, moves the encoder to the next cheaper level. Once the average
+ * stays under HEADROOM of the interval for CALM_FRAMES frames in a row that meet their deadline, it moves back one
+ * level.
+ *
+ * The levels are cumulative:
+ * 0: the configured settings
+ * 1: motion vectors refined to half samples at most
+ * 2: integer motion vectors, a search range of at most 8
+ * 3: a search range of at most 4, no B frames, twice the skip threshold
+ * 4: quantizers 2 steps coarser
+ */
+class SpeedController {
+public:
+    static constexpr int LEVEL_COUNT = 5;
+    static constexpr double HEADROOM = 0.6;
+    static constexpr int CALM_FRAMES = 15;
+
+    explicit SpeedController(const EncoderSettings& settings);
+
+    /**
+     * Account for a frame once it is encoded
+     * @param seconds The time it took to encode
+     * @return Whether the speed level changed, settings() then returns the settings of the new level
+     */
+    bool update(double seconds);
+
+    /**
+     * @return The configured settings, made cheaper for the current speed level
+     */
+    EncoderSettings settings() const;
+
+    /**
+     * @return The current speed level, 0 is the configured settings
+     */
+    int level() const {
+        return currentLevel;
+    }
+
+    /**
+     * @return The number of frames that took longer than the frame interval
+     */
+    long long deadlineMisses() const {
+        return misses;
+    }
+
+private:
+    EncoderSettings base;
+    double interval;            // seconds per frame
+
+    int currentLevel = 0;
+    long long misses = 0;
+    double averageSeconds = 0;  // over the frames of the current level
+    int framesAtLevel = 0;
+    int calmFrames = 0;
+};
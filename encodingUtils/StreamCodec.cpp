@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <cassert>
+#include "StreamCodec.hpp"
+
+using namespace std;
+
+namespace {
+    /**
+     * Continue a suspended coroutine on a worker of the pool
+     */
+    void resumeOn(ThreadPool& pool, coroutine_handle<> handle) {
+        pool.submit([handle]() {
+            handle.resume();
+        });
+    }
+}
+
+StreamEncoder::StreamEncoder(const EncoderSettings& settings, ThreadPool& pool, size_t queueCapacity):
+        encoder{settings, nullptr}, pool{pool}, queueCapacity{max<size_t>(1, queueCapacity)} {
+    assert(pool.size() > 1);
+}
+
+StreamEncoder::~StreamEncoder() {
+    unique_lock<std::mutex> lock{mutex};
+    idle.wait(lock, [this]() {
+        return not running;
+    });
+}
+
+StreamEncoder::PushAwaiter StreamEncoder::push(const Frame& frame) {
+    if(not frames) {
+        int width = frame.width(), height = frame.height();
+        frames = make_unique<Pool<Frame>>([width, height]() {
+            return make_unique<Frame>(width, height);
+        });
+    }
+    // the caller may reuse its frame as soon as push continues
+    auto copy = frames->acquire();
+    *copy = frame;
+    return PushAwaiter{*this, move(copy)};
+}
+
+StreamEncoder::FlushAwaiter StreamEncoder::flush() {
+    return FlushAwaiter{*this};
+}
+
+bool StreamEncoder::queue(shared_ptr<Frame> frame, coroutine_handle<> handle) {
+    unique_lock<std::mutex> lock{mutex};
+    if(pending.size() >= queueCapacity) {
+        // a task is encoding the pending frames, it queues this one when it takes the next
+        producer = handle;
+        producerFrame = move(frame);
+        return true;
+    }
+
+    pending.push_back(move(frame));
+    if(not running) {
+        running = true;
+        lock.unlock();
+        pool.submit([this]() {
+            drain();
+        });
+    }
+    return false;
+}
+
+bool StreamEncoder::flush(coroutine_handle<> handle) {
+    unique_lock<std::mutex> lock{mutex};
+    flusher = handle;
+    if(not running) {
+        running = true;
+        lock.unlock();
+        pool.submit([this]() {
+            drain();
+        });
+    }
+    return true;
+}
+
+vector<EncodedFrame> StreamEncoder::takePackets() {
+    lock_guard<std::mutex> lock{mutex};
+    return exchange(packets, {});
+}
+
+void StreamEncoder::drain() {
+    unique_lock<std::mutex> lock{mutex};
+    while(not pending.empty()) {
+        auto frame = move(pending.front());
+        pending.pop_front();
+        if(producer) {
+            // a place is free for the frame of the waiting coroutine
+            pending.push_back(move(producerFrame));
+            resumeOn(pool, exchange(producer, nullptr));
+        }
+
+        lock.unlock();
+        auto encoded = encoder.push(*frame);
+        frame.reset();
+        lock.lock();
+        move(encoded.begin(), encoded.end(), back_inserter(packets));
+    }
+
+    if(flusher) {
+        lock.unlock();
+        auto encoded = encoder.flush();
+        lock.lock();
+        move(encoded.begin(), encoded.end(), back_inserter(packets));
+        resumeOn(pool, exchange(flusher, nullptr));
+    }
+
+    running = false;
+    idle.notify_all();
+}
+
+StreamDecoder::StreamDecoder(ThreadPool& pool, size_t queueCapacity):
+        pool{pool}, queueCapacity{max<size_t>(1, queueCapacity)} {
+    assert(pool.size() > 1);
+}
+
+StreamDecoder::~StreamDecoder() {
+    unique_lock<std::mutex> lock{mutex};
+    idle.wait(lock, [this]() {
+        return not running;
+    });
+}
+
+StreamDecoder::PushAwaiter StreamDecoder::push(EncodedFrame packet) {
+    return PushAwaiter{*this, make_unique<EncodedFrame>(move(packet))};
+}
+
+StreamDecoder::NextAwaiter StreamDecoder::next() {
+    return NextAwaiter{*this};
+}
+
+void StreamDecoder::close() {
+    unique_lock<std::mutex> lock{mutex};
+    closed = true;
+    start(lock);
+}
+
+bool StreamDecoder::queue(unique_ptr<EncodedFrame> packet, coroutine_handle<> handle) {
+    unique_lock<std::mutex> lock{mutex};
+    assert(not closed);
+    if(error) {
+        // the stream already failed, next() reports it
+        return false;
+    }
+    if(pending.size() >= queueCapacity) {
+        // the packet is queued when the decoding task takes the next one
+        producer = handle;
+        producerPacket = move(packet);
+        return true;
+    }
+
+    pending.push_back(move(packet));
+    start(lock);
+    return false;
+}
+
+bool StreamDecoder::waitForFrame(coroutine_handle<> handle) {
+    lock_guard<std::mutex> lock{mutex};
+    if(not frames.empty() || finished) {
+        return false;
+    }
+    consumer = handle;
+    return true;
+}
+
+shared_ptr<const Frame> StreamDecoder::takeFrame() {
+    unique_lock<std::mutex> lock{mutex};
+    if(frames.empty()) {
+        if(error) {
+            rethrow_exception(error);
+        }
+        // end of the stream
+        return nullptr;
+    }
+    auto frame = move(frames.front());
+    frames.pop_front();
+    // decoding may have stopped because the frames were not taken
+    start(lock);
+    return frame;
+}
+
+void StreamDecoder::start(unique_lock<std::mutex>& lock) {
+    bool decodable = not pending.empty() && frames.size() < queueCapacity;
+    bool flushable = closed && pending.empty() && not finished;
+    if(running || error || (not decodable && not flushable)) {
+        return;
+    }
+    running = true;
+    lock.unlock();
+    pool.submit([this]() {
+        drain();
+    });
+}
+
+void StreamDecoder::drain() {
+    unique_lock<std::mutex> lock{mutex};
+    // continue the consumer once there is a frame for it, or the stream ended
+    auto wakeConsumer = [this]() {
+        if(consumer && (not frames.empty() || finished)) {
+            resumeOn(pool, exchange(consumer, nullptr));
+        }
+    };
+
+    while(not pending.empty() && frames.size() < queueCapacity) {
+        auto packet = move(pending.front());
+        pending.pop_front();
+        if(producer) {
+            pending.push_back(move(producerPacket));
+            resumeOn(pool, exchange(producer, nullptr));
+        }
+
+        lock.unlock();
+        vector<shared_ptr<const Frame>> decoded;
+        try {
+            decoded = decoder.push(*packet);
+        }
+        catch(...) {
+            lock.lock();
+            fail(current_exception());
+            wakeConsumer();
+            break;
+        }
+        packet.reset();
+        lock.lock();
+        move(decoded.begin(), decoded.end(), back_inserter(frames));
+        wakeConsumer();
+    }
+
+    if(closed && pending.empty() && not finished) {
+        lock.unlock();
+        auto decoded = decoder.flush();
+        lock.lock();
+        move(decoded.begin(), decoded.end(), back_inserter(frames));
+        finished = true;
+        wakeConsumer();
+    }
+
+    running = false;
+    idle.notify_all();
+}
+
+void StreamDecoder::fail(exception_ptr exception) {
+    // the frames decoded so far are still handed out, then next() throws
+    error = move(exception);
+    finished = true;
+    pending.clear();
+    producerPacket.reset();
+    if(producer) {
+        resumeOn(pool, exchange(producer, nullptr));
+    }
+}
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "EncodedFrame.hpp"
+#include "EncoderSettings.hpp"
+#include "Frame.hpp"
+#include "Pool.hpp"
+#include "Task.hpp"
+#include "ThreadPool.hpp"
+#include "VideoDecoder.hpp"
+#include "VideoEncoder.hpp"
+
+/**
+ * An encoder for one stream of a server that serves many streams from a few threads, used from coroutines.
+ *
+ * co_await push(frame) queues a copy of the frame and continues at once while fewer than queueCapacity frames wait,
+ * otherwise the coroutine is suspended until the stream takes the next frame. The frames are encoded one after the
+ * other by tasks on the shared ThreadPool, no thread is tied to a stream. co_await push() gives the packets finished
+ * since the previous push, co_await flush() the rest once every frame is encoded.
+ *
+ * A suspended coroutine continues on a worker of the pool. One coroutine pushes to a stream at a time.
+ * The stream must outlive its coroutines, the destructor waits for the frames still being encoded.
+ *
+ * Requires C++20.
+ */
+class StreamEncoder {
+public:
+    class PushAwaiter;
+    class FlushAwaiter;
+
+    /**
+     * @param settings The settings of the stream, threads is ignored: the block rows of a frame are coded in order
+     * @param pool The threads shared by every stream, with at least one worker thread
+     * @param queueCapacity The number of frames waiting to be encoded before push() suspends
+     */
+    StreamEncoder(const EncoderSettings& settings, ThreadPool& pool, std::size_t queueCapacity = 2);
+    ~StreamEncoder();
+
+    StreamEncoder(const StreamEncoder&) = delete;
+    StreamEncoder& operator=(const StreamEncoder&) = delete;
+
+    /**
+     * Queue the next frame of the stream, in display order
+     * @return An awaitable giving the packets finished so far, in decode order
+     */
+    PushAwaiter push(const Frame& frame);
+
+    /**
+     * End the stream
+     * @return An awaitable giving the remaining packets, in decode order, once every frame is encoded
+     */
+    FlushAwaiter flush();
+
+private:
+    bool queue(std::shared_ptr<Frame> frame, std::coroutine_handle<> handle);
+    bool flush(std::coroutine_handle<> handle);
+    std::vector<EncodedFrame> takePackets();
+    void drain();
+
+    VideoEncoder encoder;
+    ThreadPool& pool;
+    std::size_t queueCapacity;
+    std::unique_ptr<Pool<Frame>> frames;    // recycled copies of the pushed frames
+
+    std::mutex mutex;
+    std::condition_variable idle;
+    std::deque<std::shared_ptr<Frame>> pending;
+    std::vector<EncodedFrame> packets;
+    bool running = false;                   // a task of the pool is encoding the pending frames
+
+    // the coroutine waiting for a place in pending, with its frame, and the one waiting for the flush
+    std::coroutine_handle<> producer;
+    std::shared_ptr<Frame> producerFrame;
+    std::coroutine_handle<> flusher;
+};
+
+class StreamEncoder::PushAwaiter {
+public:
+    PushAwaiter(StreamEncoder& stream, std::shared_ptr<Frame> frame): stream{stream}, frame{std::move(frame)} {};
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+        return stream.queue(std::move(frame), handle);
+    }
+
+    std::vector<EncodedFrame> await_resume() {
+        return stream.takePackets();
+    }
+
+private:
+    StreamEncoder& stream;
+    std::shared_ptr<Frame> frame;
+};
+
+class StreamEncoder::FlushAwaiter {
+public:
+    explicit FlushAwaiter(StreamEncoder& stream): stream{stream} {};
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+        return stream.flush(handle);
+    }
+
+    std::vector<EncodedFrame> await_resume() {
+        return stream.takePackets();
+    }
+
+private:
+    StreamEncoder& stream;
+};
+
+/**
+ * A decoder for one stream of a server that serves many streams from a few threads, used from coroutines.
+ *
+ * co_await push(packet) queues a packet and continues at once while fewer than queueCapacity packets wait, otherwise
+ * the coroutine is suspended until the stream takes the next one. close() marks the end of the stream.
+ * co_await next() gives the decoded frames in display order, suspending until the next one is ready, and nullptr
+ * after the last one. If a packet fails to decode, next() throws the error after the frames decoded before it, and
+ * later packets are dropped. Packets are decoded by tasks on the shared ThreadPool while fewer than queueCapacity
+ * frames wait to be taken.
+ *
+ * Both sides can suspend, so push() and next() are called from two coroutines, or alternately from one.
+ * The stream must outlive its coroutines, the destructor waits for the packets still being decoded.
+ *
+ * Requires C++20.
+ */
+class StreamDecoder {
+public:
+    class PushAwaiter;
+    class NextAwaiter;
+
+    /**
+     * @param pool The threads shared by every stream, with at least one worker thread
+     * @param queueCapacity The number of packets and of frames waiting on either side of the decoder
+     */
+    explicit StreamDecoder(ThreadPool& pool, std::size_t queueCapacity = 2);
+    ~StreamDecoder();
+
+    StreamDecoder(const StreamDecoder&) = delete;
+    StreamDecoder& operator=(const StreamDecoder&) = delete;
+
+    /**
+     * Queue the next packet of the stream, in decode order
+     */
+    PushAwaiter push(EncodedFrame packet);
+
+    /**
+     * End the stream after the last push
+     */
+    void close();
+
+    /**
+     * @return An awaitable giving the next frame in display order, nullptr at the end of the stream.
+     * co_await throws the error of a packet that failed to decode.
+     */
+    NextAwaiter next();
+
+private:
+    bool queue(std::unique_ptr<EncodedFrame> packet, std::coroutine_handle<> handle);
+    bool waitForFrame(std::coroutine_handle<> handle);
+    std::shared_ptr<const Frame> takeFrame();
+    void start(std::unique_lock<std::mutex>& lock);
+    void drain();
+    void fail(std::exception_ptr exception);
+
+    VideoDecoder decoder;
+    ThreadPool& pool;
+    std::size_t queueCapacity;
+
+    std::mutex mutex;
+    std::condition_variable idle;
+    std::deque<std::unique_ptr<EncodedFrame>> pending;
+    std::deque<std::shared_ptr<const Frame>> frames;
+    bool running = false;       // a task of the pool is decoding the pending packets
+    bool closed = false;
+    bool finished = false;      // every frame is in frames
+    std::exception_ptr error;   // thrown by next() once frames is empty
+
+    // the coroutine waiting for a place in pending, with its packet, and the one waiting for a frame
+    std::coroutine_handle<> producer;
+    std::unique_ptr<EncodedFrame> producerPacket;
+    std::coroutine_handle<> consumer;
+};
+
+class StreamDecoder::PushAwaiter {
+public:
+    PushAwaiter(StreamDecoder& stream, std::unique_ptr<EncodedFrame> packet): stream{stream}, packet{std::move(packet)} {};
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+        return stream.queue(std::move(packet), handle);
+    }
+
+    void await_resume() const noexcept {}
+
+private:
+    StreamDecoder& stream;
+    std::unique_ptr<EncodedFrame> packet;
+};
+
+class StreamDecoder::NextAwaiter {
+public:
+    explicit NextAwaiter(StreamDecoder& stream): stream{stream} {};
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+        return stream.waitForFrame(handle);
+    }
+
+    std::shared_ptr<const Frame> await_resume() {
+        return stream.takeFrame();
+    }
+
+private:
+    StreamDecoder& stream;
+};
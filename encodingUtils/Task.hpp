@@ -0,0 +1,217 @@
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+/**
+ * A coroutine computing a T, started when it is awaited.
+ *
+ * The awaiting coroutine is suspended until the task is done and then continues on the thread that finished it, e.g.
+ * a worker of the ThreadPool a StreamEncoder resumed it on. An exception thrown by the task is thrown by co_await.
+ * Tasks that nobody awaits are started by a TaskGroup.
+ *
+ * Requires C++20.
+ */
+template<class T = void>
+class Task;
+
+/**
+ * The parts of the promise of a Task that do not depend on its result
+ */
+class TaskPromiseBase {
+public:
+    /**
+     * Continues the awaiting coroutine once the task is done, or tells its TaskGroup
+     */
+    class FinalAwaiter {
+    public:
+        bool await_ready() noexcept {
+            return false;
+        }
+
+        template<class Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            auto& promise = handle.promise();
+            if(promise.continuation) {
+                return promise.continuation;
+            }
+            if(promise.finished) {
+                // the group may destroy the task as soon as it is told, nothing here is touched afterwards
+                auto finished = std::move(promise.finished);
+                finished();
+            }
+            return std::noop_coroutine();
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept {
+        return {};
+    }
+
+    FinalAwaiter final_suspend() noexcept {
+        return {};
+    }
+
+    void unhandled_exception() {
+        error = std::current_exception();
+    }
+
+    std::coroutine_handle<> continuation;   // the coroutine awaiting the task
+    std::function<void()> finished;         // called when a task started by a TaskGroup is done
+    std::exception_ptr error;
+};
+
+template<class T>
+class TaskPromise : public TaskPromiseBase {
+public:
+    Task<T> get_return_object();
+
+    void return_value(T value) {
+        result = std::move(value);
+    }
+
+    T take() {
+        if(error) {
+            std::rethrow_exception(error);
+        }
+        return std::move(*result);
+    }
+
+    std::optional<T> result;
+};
+
+template<>
+class TaskPromise<void> : public TaskPromiseBase {
+public:
+    Task<void> get_return_object();
+
+    void return_void() {}
+
+    void take() {
+        if(error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+template<class T>
+class Task {
+public:
+    using promise_type = TaskPromise<T>;
+
+    explicit Task(std::coroutine_handle<promise_type> handle): handle{handle} {};
+
+    Task(Task&& other) noexcept: handle{std::exchange(other.handle, nullptr)} {};
+
+    Task& operator=(Task&& other) noexcept {
+        std::swap(handle, other.handle);
+        return *this;
+    }
+
+    ~Task() {
+        if(handle) {
+            handle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    /**
+     * Start the task, the awaiting coroutine continues when it is done
+     */
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+
+    T await_resume() {
+        return handle.promise().take();
+    }
+
+private:
+    friend class TaskGroup;
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+template<class T>
+Task<T> TaskPromise<T>::get_return_object() {
+    return Task<T>{std::coroutine_handle<TaskPromise<T>>::from_promise(*this)};
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+    return Task<void>{std::coroutine_handle<TaskPromise<void>>::from_promise(*this)};
+}
+
+/**
+ * Starts tasks that are not awaited by another coroutine, e.g. one per stream of a server, and waits for all of them.
+ *
+ * A task runs on the thread calling spawn() until it is suspended the first time, and continues wherever it is resumed.
+ */
+class TaskGroup {
+public:
+    TaskGroup() = default;
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    ~TaskGroup() {
+        std::unique_lock<std::mutex> lock{mutex};
+        done.wait(lock, [this]() {
+            return running == 0;
+        });
+    }
+
+    /**
+     * Start a task
+     */
+    void spawn(Task<void> task) {
+        auto handle = task.handle;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            running++;
+            tasks.push_back(std::move(task));
+        }
+        handle.promise().finished = [this]() {
+            std::lock_guard<std::mutex> lock{mutex};
+            running--;
+            // notified under the lock, wait() may return and the group be destroyed right after it is released
+            done.notify_all();
+        };
+        handle.resume();
+    }
+
+    /**
+     * Wait until every task started so far is done
+     * @throw The first exception thrown by one of the tasks
+     */
+    void wait() {
+        std::unique_lock<std::mutex> lock{mutex};
+        done.wait(lock, [this]() {
+            return running == 0;
+        });
+        auto finishedTasks = std::move(tasks);
+        tasks.clear();
+        lock.unlock();
+
+        for(auto& task : finishedTasks) {
+            task.handle.promise().take();
+        }
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable done;
+    std::size_t running = 0;
+    std::vector<Task<void>> tasks;
+};
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <cassert>
+#include "ThreadPool.hpp"
+
+using namespace std;
+
+namespace {
+    // the pool and the index of the worker running on this thread, nullptr outside of every pool
+    thread_local const ThreadPool* currentPool = nullptr;
+    thread_local size_t currentWorker = 0;
+}
+
+/**
+ * A parallel loop. Every task in the deques is a share of the loop that takes the next free index until there is
+ * none left, a share taken after that does nothing.
+ */
+class ThreadPool::Loop {
+public:
+    Loop(const function<void(size_t)>& task, size_t count): task{&task}, count{count}, remaining{count} {};
+
+    /**
+     * A single task owned by the loop, nobody waits for it
+     */
+    explicit Loop(function<void(size_t)> detached): detached{move(detached)}, task{&this->detached}, count{1},
+                                                     remaining{1} {};
+
+    void run() {
+        size_t completed = 0;
+        for(size_t i=next++; i<count; i=next++) {
+            (*task)(i);
+            completed++;
+        }
+        if(completed != 0) {
+            lock_guard<std::mutex> lock{mutex};
+            remaining -= completed;
+            if(remaining == 0) {
+                finished.notify_all();
+            }
+        }
+    }
+
+    bool done() {
+        lock_guard<std::mutex> lock{mutex};
+        return remaining == 0;
+    }
+
+    function<void(size_t)> detached;
+    const function<void(size_t)>* task;     // only called while indices are left, the loop owner keeps it alive
+    size_t count;
+    atomic<size_t> next{0};
+
+    std::mutex mutex;
+    condition_variable finished;
+    size_t remaining;
+};
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+    for(unsigned t=1; t<threadCount; t++) {
+        workers.push_back(make_unique<Worker>());
+    }
+    // start the threads once every deque exists, they steal from each other
+    for(size_t w=0; w<workers.size(); w++) {
+        workers[w]->thread = thread(&ThreadPool::work, this, w);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<std::mutex> lock{sleepMutex};
+        stopping = true;
+    }
+    wake.notify_all();
+    for(auto& worker : workers) {
+        worker->thread.join();
+    }
+}
+
+void ThreadPool::push(size_t worker, const shared_ptr<Loop>& loop) {
+    // counted before it is published, a thief taking it at once must not take queued below zero
+    {
+        lock_guard<std::mutex> lock{sleepMutex};
+        queued++;
+    }
+    {
+        lock_guard<std::mutex> lock{workers[worker]->mutex};
+        workers[worker]->tasks.push_back(loop);
+    }
+    wake.notify_one();
+}
+
+bool ThreadPool::runTask(size_t self) {
+    shared_ptr<Loop> loop;
+    if(self < workers.size()) {
+        lock_guard<std::mutex> lock{workers[self]->mutex};
+        if(not workers[self]->tasks.empty()) {
+            loop = move(workers[self]->tasks.back());
+            workers[self]->tasks.pop_back();
+        }
+    }
+
+    // steal, starting at the next worker so that thieves spread over the deques
+    for(size_t i=1; not loop && i<=workers.size(); i++) {
+        auto& victim = *workers[(self + i) % workers.size()];
+        lock_guard<std::mutex> lock{victim.mutex};
+        if(not victim.tasks.empty()) {
+            loop = move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+    }
+
+    if(not loop) {
+        return false;
+    }
+    queued--;
+    loop->run();
+    return true;
+}
+
+void ThreadPool::work(size_t index) {
+    currentPool = this;
+    currentWorker = index;
+
+    while(true) {
+        if(runTask(index)) {
+            continue;
+        }
+        unique_lock<std::mutex> lock{sleepMutex};
+        wake.wait(lock, [this]() {
+            return stopping || queued > 0;
+        });
+        if(stopping) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const function<void(size_t)>& task) {
+    if(workers.empty() || count <= 1) {
+        for(size_t i=0; i<count; i++) {
+            task(i);
+        }
+        return;
+    }
+
+    // a share per helping worker on the own deque, or on one of the pool from outside it
+    bool inside = currentPool == this;
+    size_t self = inside ? currentWorker : workers.size();
+    size_t home = inside ? currentWorker : nextWorker++ % workers.size();
+    auto loop = make_shared<Loop>(task, count);
+    for(size_t share=0; share<min(workers.size(), count - 1); share++) {
+        push(home, loop);
+    }
+
+    loop->run();
+
+    // the indices are all taken, help with other work until they are done
+    while(not loop->done()) {
+        if(runTask(self)) {
+            continue;
+        }
+        // every index of the loop is being run, waiting cannot block them
+        unique_lock<std::mutex> lock{loop->mutex};
+        loop->finished.wait(lock, [&]() {
+            return loop->remaining == 0;
+        });
+    }
+}
+
+void ThreadPool::submit(function<void()> task) {
+    assert(not workers.empty());
+    auto loop = make_shared<Loop>([task = move(task)](size_t) {
+        task();
+    });
+    push(currentPool == this ? currentWorker : nextWorker++ % workers.size(), loop);
+}
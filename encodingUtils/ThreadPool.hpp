@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A work stealing scheduler: a fixed set of worker threads, started once and shared by every parallel stage.
+ *
+ * Every worker has its own deque of tasks. It runs the newest task of its own deque first and, once that is empty,
+ * steals the oldest task of another worker, so cheap and expensive tasks of different loops even out without a
+ * barrier per loop. A thread waiting for its loop runs other tasks in the meantime.
+ *
+ * parallelFor() hands out the task indices of a loop in ascending order, an index is only handed out once every
+ * index before it is being run. Tasks write their results to their own slots, callers join them in index order so
+ * the result does not depend on the number of threads.
+ */
+class ThreadPool {
+public:
+    /**
+     * @param threadCount The number of threads working on a loop, the calling thread included
+     */
+    explicit ThreadPool(unsigned threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @return The number of threads working on a loop, the calling thread included
+     */
+    unsigned size() const {
+        return static_cast<unsigned>(workers.size()) + 1;
+    }
+
+    /**
+     * Run task(0) to task(count - 1) on the pool and wait for all of them.
+     * May be called from several threads at once and from a task of another loop.
+     */
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)>& task);
+
+    /**
+     * Run a task on one of the worker threads without waiting for it, e.g. to resume a suspended coroutine.
+     * The pool needs at least one worker thread, size() > 1. Tasks left when the pool is destroyed are dropped.
+     */
+    void submit(std::function<void()> task);
+
+private:
+    class Loop;
+
+    /**
+     * The deque of a worker. The worker pushes and pops at the back, thieves take from the front.
+     */
+    class Worker {
+    public:
+        std::mutex mutex;
+        std::deque<std::shared_ptr<Loop>> tasks;
+        std::thread thread;
+    };
+
+    void work(std::size_t index);
+    void push(std::size_t worker, const std::shared_ptr<Loop>& loop);
+
+    /**
+     * Run one task: the newest of the own deque, else the oldest of another worker
+     * @param self The index of the calling worker, workers.size() for a thread outside the pool
+     * @return false if every deque was empty
+     */
+    bool runTask(std::size_t self);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<std::size_t> nextWorker{0};     // the deque of the next loop started outside the pool
+
+    // idle workers sleep until a task is pushed
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<std::size_t> queued{0};         // tasks in all deques
+    bool stopping = false;
+};
@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <stdexcept>
+#include "TiledFrame.hpp"
+
+using namespace std;
+
+TiledFrame TiledFrame::encode(const tuple<vector<Block>, vector<Block>, vector<Block>>& blocks, int blocksPerRow,
+                              int tileColumns, int tileRows, EntropyMode mode, ThreadPool& pool) {
+    TiledFrame output;
+    output.mode = mode;
+    output.blocksPerRow = blocksPerRow;
+    output.blockRows = static_cast<int>(get<0>(blocks).size()) / blocksPerRow;
+    output.tileColumns = max(1, min(tileColumns, blocksPerRow));
+    output.tileRows = max(1, min(tileRows, output.blockRows));
+
+    // every tile is coded into its own buffer by its own coder, the buffers are joined in order
+    int tileCount = output.tileColumns * output.tileRows;
+    vector<vector<unsigned char>> tiles(tileCount);
+    pool.parallelFor(tileCount, [&](size_t tile) {
+        int tileRow = static_cast<int>(tile) / output.tileColumns, tileColumn = static_cast<int>(tile) % output.tileColumns;
+        int firstColumn = output.columnStart(tileColumn), lastColumn = output.columnStart(tileColumn + 1);
+        auto coder = EntropyCoder::create(mode, lastColumn - firstColumn);
+
+        for(int row=output.rowStart(tileRow); row<output.rowStart(tileRow + 1); row++) {
+            for(int column=firstColumn; column<lastColumn; column++) {
+                int i = row * blocksPerRow + column;
+                const Block* sources[3] = {&get<0>(blocks)[i], &get<1>(blocks)[i], &get<2>(blocks)[i]};
+                for(auto source : sources) {
+                    // skip the DCT part, expand to 8x8
+                    auto expanded = source->expandTo8x8();
+                    coder->encodeBlock(*expanded);
+                    delete expanded;
+                }
+            }
+        }
+        tiles[tile] = coder->finish();
+    });
+
+    for(const auto& tile : tiles) {
+        output.tileOffsets.push_back(output.bytes.size());
+        output.bytes.insert(output.bytes.end(), tile.begin(), tile.end());
+    }
+    return output;
+}
+
+bool TiledFrame::decodeTile(int tile, vector<Block*>& Y, vector<Block*>& U, vector<Block*>& V) const {
+    int tileRow = tile / tileColumns, tileColumn = tile % tileColumns;
+    int firstColumn = columnStart(tileColumn), lastColumn = columnStart(tileColumn + 1);
+    size_t start = tileOffsets[tile];
+    size_t end = tile + 1 < static_cast<int>(tileOffsets.size()) ? tileOffsets[tile + 1] : bytes.size();
+    if(start > end || end > bytes.size()) {
+        return false;
+    }
+
+    auto coder = EntropyCoder::create(mode, lastColumn - firstColumn);
+    coder->startDecoding(bytes.data() + start, end - start);
+
+    vector<Block*>* outputs[3] = {&Y, &U, &V};
+    const BlockType types[3] = {BlockType::Y, BlockType::U, BlockType::V};
+    vector<int> zigZagValues;
+
+    // the tile writes its own blocks only
+    for(int row=rowStart(tileRow); row<rowStart(tileRow + 1); row++) {
+        for(int column=firstColumn; column<lastColumn; column++) {
+            for(int c=0; c<3; c++) {
+                if(not coder->decodeBlock(types[c], zigZagValues)) {
+                    return false;
+                }
+
+                auto block = new Block(Block::zigZagReverse(zigZagValues));
+                block->setType(types[c]);
+                (*outputs[c])[row * blocksPerRow + column] = block;
+            }
+        }
+    }
+    return true;
+}
+
+tuple<vector<Block*>, vector<Block*>, vector<Block*>> TiledFrame::decode(ThreadPool& pool) const {
+    return decodeRegion(0, 0, blockRows, blocksPerRow, pool);
+}
+
+tuple<vector<Block*>, vector<Block*>, vector<Block*>> TiledFrame::decodeRegion(int top, int left, int rows,
+                                                                              int columns, ThreadPool& pool) const {
+    size_t blockCount = static_cast<size_t>(blocksPerRow) * blockRows;
+    vector<Block*> Y(blockCount, nullptr), U(blockCount, nullptr), V(blockCount, nullptr);
+
+    // the tiles overlapping the region
+    vector<int> tiles;
+    for(int tileRow=0; tileRow<tileRows; tileRow++) {
+        if(rowStart(tileRow + 1) <= top || rowStart(tileRow) >= top + rows) {
+            continue;
+        }
+        for(int tileColumn=0; tileColumn<tileColumns; tileColumn++) {
+            if(columnStart(tileColumn + 1) > left && columnStart(tileColumn) < left + columns) {
+                tiles.push_back(tileRow * tileColumns + tileColumn);
+            }
+        }
+    }
+
+    vector<char> decoded(tiles.size());
+    pool.parallelFor(tiles.size(), [&](size_t i) {
+        decoded[i] = decodeTile(tiles[i], Y, U, V);
+    });
+
+    auto damaged = find(decoded.begin(), decoded.end(), 0);
+    if(damaged != decoded.end()) {
+        for(auto component : {&Y, &U, &V}) {
+            for(auto block : *component) {
+                delete block;
+            }
+        }
+        throw runtime_error("corrupt tile " + to_string(tiles[damaged - decoded.begin()]));
+    }
+
+    return make_tuple(Y, U, V);
+}
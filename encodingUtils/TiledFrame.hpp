@@ -0,0 +1,78 @@
+#pragma once
+
+#include <tuple>
+#include <vector>
+
+#include "Block.hpp"
+#include "EntropyCoder.hpp"
+#include "ThreadPool.hpp"
+
+/**
+ * A frame entropy coded as a grid of independent rectangular tiles.
+ *
+ * Every tile has its own coder, so no context or prediction crosses a tile border. The tiles are stored one after
+ * the other in raster order, each at its own offset in bytes. They can be coded and decoded in any order and on
+ * separate threads, and a region of the frame can be decoded without the tiles outside of it.
+ *
+ * The block columns are split as evenly as possible between the tile columns, and the block rows between the tile
+ * rows.
+ */
+class TiledFrame {
+public:
+    EntropyMode mode = RUN_LENGTH;
+    int blocksPerRow = 0;
+    int blockRows = 0;
+    int tileColumns = 1;
+    int tileRows = 1;
+    std::vector<size_t> tileOffsets;    // start of each tile in bytes, the tiles in raster order
+    std::vector<unsigned char> bytes;
+
+    /**
+     * Entropy-code the blocks of a frame tile by tile on the threads of a pool
+     * @param blocks The Y, U and V blocks of the frame, U and V still 4x4
+     * @param blocksPerRow The number of blocks in a block row of the frame
+     * @param tileColumns The number of tiles across, at most blocksPerRow
+     * @param tileRows The number of tiles down, at most the number of block rows
+     * @param mode The entropy mode of every tile
+     */
+    static TiledFrame encode(const std::tuple<std::vector<Block>, std::vector<Block>, std::vector<Block>>& blocks,
+                             int blocksPerRow, int tileColumns, int tileRows, EntropyMode mode, ThreadPool& pool);
+
+    /**
+     * Decode every tile on the threads of a pool
+     * @return The 8x8 Y, Cb and Cr blocks in frame order, with their types set
+     * @throw runtime_error if a tile is truncated or corrupt, no blocks are returned then
+     */
+    std::tuple<std::vector<Block*>, std::vector<Block*>, std::vector<Block*>> decode(ThreadPool& pool) const;
+
+    /**
+     * Decode only the tiles overlapping a region of the frame
+     * @param top The first block row of the region
+     * @param left The first block column of the region
+     * @param rows The number of block rows of the region
+     * @param columns The number of block columns of the region
+     * @return The blocks in frame order, nullptr for the blocks of the tiles that were not decoded
+     * @throw runtime_error if one of the decoded tiles is truncated or corrupt
+     */
+    std::tuple<std::vector<Block*>, std::vector<Block*>, std::vector<Block*>> decodeRegion(int top, int left, int rows,
+                                                                                          int columns,
+                                                                                          ThreadPool& pool) const;
+
+    /**
+     * @return The first block column of a tile column, tileColumns gives the end of the last one
+     */
+    int columnStart(int tileColumn) const {
+        return tileColumn * blocksPerRow / tileColumns;
+    }
+
+    /**
+     * @return The first block row of a tile row, tileRows gives the end of the last one
+     */
+    int rowStart(int tileRow) const {
+        return tileRow * blockRows / tileRows;
+    }
+
+private:
+    // false if the tile is truncated or corrupt, the blocks decoded so far are kept
+    bool decodeTile(int tile, std::vector<Block*>& Y, std::vector<Block*>& U, std::vector<Block*>& V) const;
+};
@@ -0,0 +1,173 @@
+#include <stdexcept>
+#include "VideoDecoder.hpp"
+#include "MotionCompensation.hpp"
+
+using namespace std;
+
+void VideoDecoder::decodeBlock(EntropyDecoder& decoder, const Matrix<int, Dynamic, Dynamic>& prediction,
+                               Plane& output, int top, int left, int size, int quantizer) {
+    if(not decoder.decodeNext(zigZagValues)) {
+        throw runtime_error("truncated or corrupt coefficients");
+    }
+
+    Block residual{Block::zigZagReverse(zigZagValues)};
+    if(size == 4) {
+        // chroma residuals were expanded to 8x8, compress them back
+        auto compressed = residual.compressTo4x4();
+        residual.values = compressed->values.topLeftCorner(4, 4);
+        delete compressed;
+    }
+    MotionCompensation::dequantize(residual.values, quantizer);
+
+    MotionCompensation::reconstruct(output, top, left, prediction, residual.values);
+}
+
+void VideoDecoder::allocate(int width, int height) {
+    pictures = make_unique<Pool<Frame>>([width, height]() {
+        return make_unique<Frame>(width, height);
+    });
+    references = make_unique<Pool<InterpolatedFrame>>([width, height]() {
+        return make_unique<InterpolatedFrame>(width, height);
+    });
+}
+
+std::shared_ptr<const Frame> VideoDecoder::decodePicture(const EncodedFrame& frame) {
+    if(not pictures) {
+        allocate(frame.width, frame.height);
+    }
+
+    // I and P frames are decoded into a recycled reference, B frames into a recycled frame
+    shared_ptr<InterpolatedFrame> reference;
+    shared_ptr<Frame> picture;
+    if(frame.type != B_FRAME) {
+        reference = references->acquire();
+    }
+    else {
+        picture = pictures->acquire();
+    }
+    Frame& output = reference ? reference->frame : *picture;
+    output.frameNumber = frame.frameNumber;
+    EntropyDecoder decoder{frame.coefficients};
+
+    // P frames predict from the last I or P frame, B frames from the two last ones
+    const InterpolatedFrame* forwardFrame = frame.type == B_FRAME ? previousAnchor.get() : lastAnchor.get();
+
+    int blockIdx = 0;
+    size_t vectorIdx = 0;
+    size_t backwardIdx = 0;
+    size_t directionIdx = 0;
+    for(int top=0; top<frame.height; top+=8) {
+        int quantizer = frame.quantizerOfRow(top / 8);
+        for(int left=0; left<frame.width; left+=8, blockIdx++) {
+            if(frame.type == I_FRAME) {
+                const auto intraPrediction = [](int size) {
+                    return Matrix<int, Dynamic, Dynamic>::Constant(size, size, MotionCompensation::INTRA_PREDICTION);
+                };
+                decodeBlock(decoder, intraPrediction(8), output.y, top, left, 8, quantizer);
+                decodeBlock(decoder, intraPrediction(4), output.cb, top / 2, left / 2, 4, quantizer);
+                decodeBlock(decoder, intraPrediction(4), output.cr, top / 2, left / 2, 4, quantizer);
+                continue;
+            }
+
+            if(frame.skipFlags[blockIdx]) {
+                MotionCompensation::copy(forwardFrame->frame.y, output.y, top, left, 8);
+                MotionCompensation::copy(forwardFrame->frame.cb, output.cb, top / 2, left / 2, 4);
+                MotionCompensation::copy(forwardFrame->frame.cr, output.cr, top / 2, left / 2, 4);
+                continue;
+            }
+
+            // directions are only coded for the blocks of B frames that are not skipped
+            auto direction = frame.type == B_FRAME ? frame.directions[directionIdx++] : FORWARD;
+            MotionVector forwardMv, backwardMv;
+            if(direction != BACKWARD) {
+                forwardMv = frame.motionVectors[vectorIdx++];
+            }
+            if(direction != FORWARD) {
+                backwardMv = frame.backwardVectors[backwardIdx++];
+            }
+            auto forwardChroma = MotionCompensation::chromaVector(forwardMv);
+            auto backwardChroma = MotionCompensation::chromaVector(backwardMv);
+
+            decodeBlock(decoder, MotionCompensation::predict(direction, forwardFrame->y(), lastAnchor->y(), top, left, 8,
+                                                             forwardMv, backwardMv),
+                        output.y, top, left, 8, quantizer);
+            decodeBlock(decoder, MotionCompensation::predict(direction, forwardFrame->cb(), lastAnchor->cb(), top / 2,
+                                                             left / 2, 4, forwardChroma, backwardChroma),
+                        output.cb, top / 2, left / 2, 4, quantizer);
+            decodeBlock(decoder, MotionCompensation::predict(direction, forwardFrame->cr(), lastAnchor->cr(), top / 2,
+                                                             left / 2, 4, forwardChroma, backwardChroma),
+                        output.cr, top / 2, left / 2, 4, quantizer);
+        }
+    }
+
+    if(frame.type == B_FRAME) {
+        return picture;
+    }
+
+    reference->interpolate();
+    previousAnchor = move(lastAnchor);
+    lastAnchor = move(reference);
+    // the frame of the reference, sharing its ownership
+    return shared_ptr<const Frame>(lastAnchor, &lastAnchor->frame);
+}
+
+std::shared_ptr<const Frame> VideoDecoder::decode(const EncodedFrame& frame) {
+    lastStream = nullptr;
+    return decodePicture(frame);
+}
+
+std::vector<std::shared_ptr<const Frame>> VideoDecoder::push(const EncodedFrame& frame) {
+    vector<shared_ptr<const Frame>> output;
+    auto decoded = decode(frame);
+    if(frame.type != B_FRAME) {
+        // every frame before an I or P frame in display order is decoded before it
+        output = flush();
+    }
+    reorderBuffer.emplace(frame.frameNumber, move(decoded));
+    return output;
+}
+
+std::vector<std::shared_ptr<const Frame>> VideoDecoder::flush() {
+    vector<shared_ptr<const Frame>> output;
+    for(auto& entry : reorderBuffer) {
+        output.push_back(move(entry.second));
+    }
+    reorderBuffer.clear();
+    return output;
+}
+
+std::shared_ptr<const Frame> VideoDecoder::decodeFrame(const VideoStream& stream, int frameNumber) {
+    int target = stream.positionOf(frameNumber);
+    if(target < 0) {
+        throw out_of_range("frame " + to_string(frameNumber) + " is not in the stream");
+    }
+
+    int start = stream.keyframeBefore(target);
+    if(frameNumber < stream.frames[start].frameNumber) {
+        // B frame of an open GOP shown before its keyframe, it also references the GOP before
+        start = stream.keyframeBefore(start - 1);
+    }
+
+    if(lastStream == &stream && lastPosition == target) {
+        return shared_ptr<const Frame>(lastAnchor, &lastAnchor->frame);
+    }
+    if(lastStream == &stream && lastPosition >= start && lastPosition < target) {
+        // the references up to the last decoded one are already done
+        start = lastPosition + 1;
+    }
+
+    // B frames are never referenced, only the I and P frames before the target are needed
+    for(int position=start; position<target; position++) {
+        if(stream.frames[position].type != B_FRAME) {
+            decodePicture(stream.frames[position]);
+            lastPosition = position;
+        }
+    }
+    auto output = decodePicture(stream.frames[target]);
+    if(stream.frames[target].type != B_FRAME) {
+        lastPosition = target;
+    }
+
+    lastStream = &stream;
+    return output;
+}
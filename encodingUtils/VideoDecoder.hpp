@@ -0,0 +1,76 @@
+#pragma once
+
+#include <map>
+#include <memory>
+
+#include "EncodedFrame.hpp"
+#include "EntropyDecoder.hpp"
+#include "Frame.hpp"
+#include "Interpolation.hpp"
+#include "Pool.hpp"
+#include "VideoStream.hpp"
+
+/**
+ * Decodes the frames of a VideoEncoder in decode order. The last two decoded I or P frames are kept as the
+ * references of the following P and B frames.
+ *
+ * Decoded frames are handed out as shared pointers to recycled buffers, an I or P frame is the reference itself.
+ * A frame goes back to the decoder when the last pointer to it is released, the decoder allocates no frame buffers
+ * once it has as many as the caller holds on to.
+ */
+class VideoDecoder {
+public:
+    /**
+     * Decode the next frame of the sequence
+     * @param frame The encoded frame, P and B frames need their references to be decoded first
+     * @return The frame, in decode order, tagged with its display frame number
+     * @throw runtime_error if the coefficients of the frame are truncated or corrupt
+     */
+    std::shared_ptr<const Frame> decode(const EncodedFrame& frame);
+
+    /**
+     * Decode the next frame of the sequence and reorder the output to display order
+     * @param frame The encoded frame, in decode order
+     * @return The frames that are complete in display order, possibly none
+     */
+    std::vector<std::shared_ptr<const Frame>> push(const EncodedFrame& frame);
+
+    /**
+     * @return The frames left in the reorder buffer, at the end of the sequence
+     */
+    std::vector<std::shared_ptr<const Frame>> flush();
+
+    /**
+     * Decode a frame of a stream by its display frame number.
+     * Only the I and P frames before it are decoded, starting at the closest keyframe before it, or continuing from
+     * the frame decoded last if that is closer.
+     * @param stream The stream
+     * @param frameNumber The display frame number of the wanted frame
+     * @throw out_of_range if the stream has no frame with that number, or no keyframe it can be decoded from
+     * @throw runtime_error if a frame on the way is truncated or corrupt
+     */
+    std::shared_ptr<const Frame> decodeFrame(const VideoStream& stream, int frameNumber);
+
+private:
+    std::shared_ptr<const Frame> decodePicture(const EncodedFrame& frame);
+    void decodeBlock(EntropyDecoder& decoder, const Matrix<int, Dynamic, Dynamic>& prediction, Plane& output,
+                     int top, int left, int size, int quantizer);
+    void allocate(int width, int height);
+
+    // recycled B frames and references, created for the size of the first frame
+    std::unique_ptr<Pool<Frame>> pictures;
+    std::unique_ptr<Pool<InterpolatedFrame>> references;
+
+    // reconstructions of the last two I or P frames
+    std::shared_ptr<const InterpolatedFrame> previousAnchor;
+    std::shared_ptr<const InterpolatedFrame> lastAnchor;
+
+    // decoded frames waiting for the frames before them in display order, by display frame number
+    std::map<int, std::shared_ptr<const Frame>> reorderBuffer;
+
+    // position in the stream of the frame in lastAnchor, when it was decoded by decodeFrame
+    const VideoStream* lastStream = nullptr;
+    int lastPosition = -1;
+
+    std::vector<int> zigZagValues;
+};
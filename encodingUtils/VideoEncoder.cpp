@@ -0,0 +1,429 @@
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <mutex>
+#include "VideoEncoder.hpp"
+#include "MotionCompensation.hpp"
+#include "BlockCost.hpp"
+
+using namespace std;
+
+/**
+ * The vectors chosen so far in the current frame, one per block and reference, used to seed the searches of the
+ * following blocks. Blocks that do not use a reference count as zero vectors for it.
+ */
+class VideoEncoder::BlockVectors {
+public:
+    BlockVectors(int blocksPerRow, int blockCount, const vector<MotionVector>& previous):
+            blocksPerRow{blocksPerRow}, forward(blockCount), backward(blockCount), previous{previous} {};
+
+    /**
+     * Starting points for the search of a block: the median, the left, upper and upper right neighbours and, for
+     * the forward vectors, the vector of the same block in the last P frame
+     */
+    void predictors(const vector<MotionVector>& vectors, int blockIdx, vector<MotionVector>& output) const {
+        output.clear();
+        output.push_back(MotionEstimator::medianPredictor(vectors, blockIdx, blocksPerRow));
+        if(blockIdx % blocksPerRow > 0) {
+            output.push_back(vectors[blockIdx - 1]);
+        }
+        if(blockIdx >= blocksPerRow) {
+            output.push_back(vectors[blockIdx - blocksPerRow]);
+            if(blockIdx % blocksPerRow + 1 < blocksPerRow) {
+                output.push_back(vectors[blockIdx - blocksPerRow + 1]);
+            }
+        }
+        if(&vectors == &forward && previous.size() == forward.size()) {
+            output.push_back(previous[blockIdx]);
+        }
+    }
+
+    void set(int blockIdx, const MotionVector& forwardMv, const MotionVector& backwardMv) {
+        forward[blockIdx] = forwardMv;
+        backward[blockIdx] = backwardMv;
+    }
+
+    int blocksPerRow;
+    vector<MotionVector> forward;
+    vector<MotionVector> backward;
+    const vector<MotionVector>& previous;   // forward vectors of the last P frame, empty after a keyframe
+};
+
+/**
+ * The number of blocks coded in every block row of a frame coded as a wavefront
+ */
+class VideoEncoder::RowProgress {
+public:
+    explicit RowProgress(int rows): done(rows, 0) {};
+
+    /**
+     * Wait until a row has coded at least the given number of blocks, rows above the frame are complete
+     */
+    void waitFor(int row, int blocks) {
+        if(row < 0) {
+            return;
+        }
+        unique_lock<mutex> lock{rowsMutex};
+        advanced.wait(lock, [&]() {
+            return done[row] >= blocks;
+        });
+    }
+
+    void advance(int row) {
+        {
+            lock_guard<mutex> lock{rowsMutex};
+            done[row]++;
+        }
+        advanced.notify_all();
+    }
+
+private:
+    vector<int> done;
+    mutex rowsMutex;
+    condition_variable advanced;
+};
+
+/**
+ * Code the residual of a block against its prediction and write the reconstruction
+ */
+void VideoEncoder::encodeBlock(const Plane& source, Plane& reconstructed, BlockType type, int top, int left,
+                               const Matrix<int, Dynamic, Dynamic>& prediction, EncodedFrame& output) const {
+    Block residual{MotionCompensation::residual(source, top, left, prediction)};
+    residual.setType(type);
+    MotionCompensation::quantize(residual.values, output.quantizer, output.type == I_FRAME);
+
+    // skip the DCT part, expand to 8x8
+    auto expanded = residual.expandTo8x8();
+    auto encoded = expanded->entropy_encode();
+    delete expanded;
+    output.coefficients.insert(output.coefficients.end(), encoded.begin(), encoded.end());
+
+    // reconstruct from the quantized residual, like the decoder
+    MotionCompensation::dequantize(residual.values, output.quantizer);
+    MotionCompensation::reconstruct(reconstructed, top, left, prediction, residual.values);
+}
+
+/**
+ * Check if a block matches its co-located reference block closely enough to be skipped
+ */
+bool VideoEncoder::isStatic(const Frame& frame, const InterpolatedFrame& referenceFrame, int top, int left,
+                            int quantizer) const {
+    if(settings.skipThreshold < 0) {
+        return false;
+    }
+    // differences the quantizer would mostly remove anyway
+    int threshold = settings.skipThreshold * quantizer;
+
+    const Frame& reference = referenceFrame.frame;
+    int lumaCost = BlockCost::sad8x8(frame.y.row(top) + left, frame.y.stride,
+                                     reference.y.row(top) + left, reference.y.stride);
+    if(lumaCost > threshold) {
+        return false;
+    }
+
+    for(auto planes : {make_pair(&frame.cb, &reference.cb), make_pair(&frame.cr, &reference.cr)}) {
+        int chromaCost = BlockCost::sadScalar(planes.first->row(top / 2) + left / 2, planes.first->stride,
+                                              planes.second->row(top / 2) + left / 2, planes.second->stride, 4);
+        if(chromaCost > threshold / 4) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Code a block of a P or B frame: skip it, or search its vector(s) and code the residual
+ */
+void VideoEncoder::encodeInterBlock(const Frame& frame, Frame& reconstructed, int top, int left,
+                                    BlockVectors& vectors, std::vector<MotionVector>& predictors,
+                                    EncodedFrame& output) {
+    int blockIdx = top / 8 * vectors.blocksPerRow + left / 8;
+
+    // P frames predict from the last I or P frame, B frames from the two around them
+    const InterpolatedFrame& forwardFrame = output.type == P_FRAME ? *lastAnchor : *previousAnchor;
+    const InterpolatedFrame& backwardFrame = *lastAnchor;
+
+    bool skip = isStatic(frame, forwardFrame, top, left, output.quantizer);
+    output.skipFlags.push_back(skip);
+    if(skip) {
+        // nothing is coded, the decoder copies the reference block
+        MotionCompensation::copy(forwardFrame.frame.y, reconstructed.y, top, left, 8);
+        MotionCompensation::copy(forwardFrame.frame.cb, reconstructed.cb, top / 2, left / 2, 4);
+        MotionCompensation::copy(forwardFrame.frame.cr, reconstructed.cr, top / 2, left / 2, 4);
+        vectors.set(blockIdx, MotionVector{0, 0}, MotionVector{0, 0});
+        return;
+    }
+
+    vectors.predictors(vectors.forward, blockIdx, predictors);
+    auto forwardMv = estimator.search(frame.y, forwardFrame.y(), top, left, predictors);
+    MotionVector backwardMv;
+    auto direction = FORWARD;
+
+    if(output.type == B_FRAME) {
+        vectors.predictors(vectors.backward, blockIdx, predictors);
+        backwardMv = backwardEstimator.search(frame.y, backwardFrame.y(), top, left, predictors);
+
+        // pick the prediction with the lowest luma SAD
+        int bestCost = INT_MAX;
+        for(auto candidate : {FORWARD, BACKWARD, BIDIRECTIONAL}) {
+            auto prediction = MotionCompensation::predict(candidate, forwardFrame.y(), backwardFrame.y(), top, left, 8,
+                                                          forwardMv, backwardMv);
+            int cost = MotionCompensation::residual(frame.y, top, left, prediction).cwiseAbs().sum();
+            if(cost < bestCost) {
+                bestCost = cost;
+                direction = candidate;
+            }
+        }
+        output.directions.push_back(direction);
+    }
+
+    if(direction != BACKWARD) {
+        output.motionVectors.push_back(forwardMv);
+    }
+    if(direction != FORWARD) {
+        output.backwardVectors.push_back(backwardMv);
+    }
+    vectors.set(blockIdx, direction != BACKWARD ? forwardMv : MotionVector{},
+                direction != FORWARD ? backwardMv : MotionVector{});
+
+    auto forwardChroma = MotionCompensation::chromaVector(forwardMv);
+    auto backwardChroma = MotionCompensation::chromaVector(backwardMv);
+
+    encodeBlock(frame.y, reconstructed.y, Y, top, left,
+                MotionCompensation::predict(direction, forwardFrame.y(), backwardFrame.y(), top, left, 8,
+                                            forwardMv, backwardMv), output);
+    encodeBlock(frame.cb, reconstructed.cb, U, top / 2, left / 2,
+                MotionCompensation::predict(direction, forwardFrame.cb(), backwardFrame.cb(), top / 2, left / 2, 4,
+                                            forwardChroma, backwardChroma), output);
+    encodeBlock(frame.cr, reconstructed.cr, V, top / 2, left / 2,
+                MotionCompensation::predict(direction, forwardFrame.cr(), backwardFrame.cr(), top / 2, left / 2, 4,
+                                            forwardChroma, backwardChroma), output);
+}
+
+/**
+ * Code the blocks of a block row
+ * @param progress The progress of the rows of a wavefront, the row waits for the blocks above right of its blocks.
+ *                 nullptr if the rows are coded in order.
+ * @param output The buffer of the row, with its frame type and quantizer set
+ */
+void VideoEncoder::encodeRow(const Frame& frame, Frame& reconstructed, int blockRow, BlockVectors& vectors,
+                             RowProgress* progress, EncodedFrame& output) {
+    const auto intraPrediction = [](int size) {
+        return Matrix<int, Dynamic, Dynamic>::Constant(size, size, MotionCompensation::INTRA_PREDICTION);
+    };
+
+    int top = 8 * blockRow;
+    vector<MotionVector> predictors;
+    for(int left=0; left<frame.width(); left+=8) {
+        if(progress) {
+            // the median predictor needs the vector of the block above right
+            progress->waitFor(blockRow - 1, min(left / 8 + 2, vectors.blocksPerRow));
+        }
+
+        if(output.type != I_FRAME) {
+            encodeInterBlock(frame, reconstructed, top, left, vectors, predictors, output);
+        }
+        else {
+            encodeBlock(frame.y, reconstructed.y, Y, top, left, intraPrediction(8), output);
+            encodeBlock(frame.cb, reconstructed.cb, U, top / 2, left / 2, intraPrediction(4), output);
+            encodeBlock(frame.cr, reconstructed.cr, V, top / 2, left / 2, intraPrediction(4), output);
+        }
+
+        if(progress) {
+            progress->advance(blockRow);
+        }
+    }
+}
+
+EncodedFrame VideoEncoder::encodePicture(const Frame& frame, FrameType type) {
+    EncodedFrame output;
+    output.type = type;
+    output.frameNumber = frame.frameNumber;
+    output.width = frame.width();
+    output.height = frame.height();
+
+    // I and P frames are reconstructed into a recycled reference, B frames into the same scratch frame
+    shared_ptr<InterpolatedFrame> reference;
+    if(type != B_FRAME) {
+        reference = references->acquire();
+    }
+    Frame& reconstructed = reference ? reference->frame : reconstructedB;
+    reconstructed.frameNumber = frame.frameNumber;
+
+    if(type == P_FRAME) {
+        estimator.prepare(frame.y, lastAnchor->frame.y);
+    }
+    else if(type == B_FRAME) {
+        estimator.prepare(frame.y, previousAnchor->frame.y);
+        backwardEstimator.prepare(frame.y, lastAnchor->frame.y);
+    }
+
+    output.quantizer = rateController.frameQuantizer(type, frame);
+    bool rowRateControl = settings.rowRateControl && settings.rateControl != CONSTANT_QUALITY;
+
+    // every block row is coded into its own buffer, the buffers are joined in raster order
+    int blockRows = frame.height() / 8;
+    vector<EncodedFrame> rows(blockRows);
+    for(auto& row : rows) {
+        row.type = type;
+        row.quantizer = output.quantizer;
+    }
+    BlockVectors vectors{frame.width() / 8, blockRows * (frame.width() / 8), previousVectors};
+
+    if(pool && not rowRateControl) {
+        RowProgress progress{blockRows};
+        pool->parallelFor(blockRows, [&](size_t row) {
+            encodeRow(frame, reconstructed, static_cast<int>(row), vectors, &progress, rows[row]);
+        });
+    }
+    else {
+        long long rowBits = 0;
+        for(int row=0; row<blockRows; row++) {
+            if(rowRateControl) {
+                if(row > 0) {
+                    rowBits += RateController::coefficientBits(rows[row - 1].coefficients.data(),
+                                                               rows[row - 1].coefficients.data()
+                                                               + rows[row - 1].coefficients.size());
+                    rows[row].quantizer = rateController.rowQuantizer(row, rowBits);
+                }
+                output.rowQuantizers.push_back(rows[row].quantizer);
+            }
+            encodeRow(frame, reconstructed, row, vectors, nullptr, rows[row]);
+        }
+    }
+
+    for(const auto& row : rows) {
+        output.skipFlags.insert(output.skipFlags.end(), row.skipFlags.begin(), row.skipFlags.end());
+        output.motionVectors.insert(output.motionVectors.end(), row.motionVectors.begin(), row.motionVectors.end());
+        output.directions.insert(output.directions.end(), row.directions.begin(), row.directions.end());
+        output.backwardVectors.insert(output.backwardVectors.end(), row.backwardVectors.begin(),
+                                      row.backwardVectors.end());
+        output.coefficients.insert(output.coefficients.end(), row.coefficients.begin(), row.coefficients.end());
+    }
+
+    rateController.update(output);
+
+    if(type == P_FRAME) {
+        previousVectors = move(vectors.forward);
+    }
+    else if(type == I_FRAME) {
+        previousVectors.clear();
+    }
+
+    if(type != B_FRAME) {
+        // I and P frames become the references of the following frames, interpolated once
+        reference->interpolate();
+        previousAnchor = move(lastAnchor);
+        lastAnchor = move(reference);
+    }
+    if(type == I_FRAME) {
+        lastKeyframe = frame.frameNumber;
+        sceneCuts.erase(frame.frameNumber);
+    }
+    return output;
+}
+
+bool VideoEncoder::isKeyframe(int frameNumber) const {
+    return lastKeyframe < 0
+        || frameNumber - lastKeyframe >= settings.keyframeInterval
+        || settings.forcedKeyframes.count(frameNumber) != 0
+        || sceneCuts.count(frameNumber) != 0;
+}
+
+void VideoEncoder::encodeGroup(std::vector<EncodedFrame>& output) {
+    int groupSize = min(static_cast<int>(lookahead.size()), settings.bFrames + 1);
+    int anchor = groupSize - 1;
+    auto anchorType = P_FRAME;
+
+    for(int i=0; i<groupSize; i++) {
+        if(isKeyframe(lookahead[i]->frameNumber)) {
+            if(i == 0 || not settings.closedGop) {
+                // open GOP: the frames before the keyframe are B frames that also reference the previous GOP
+                anchor = i;
+                anchorType = I_FRAME;
+            }
+            else {
+                // closed GOP: the frames before the keyframe end the current GOP, the keyframe starts the next group
+                anchor = i - 1;
+            }
+            break;
+        }
+    }
+
+    // the I or P frame first, then the frames before it in display order predicted from both sides
+    encodeTimed(*lookahead[anchor], anchorType, output);
+    for(int i=0; i<anchor; i++) {
+        encodeTimed(*lookahead[i], B_FRAME, output);
+    }
+
+    lookahead.erase(lookahead.begin(), lookahead.begin() + anchor + 1);
+}
+
+/**
+ * Encode a frame and, in real time mode, account for its encode time
+ */
+void VideoEncoder::encodeTimed(const Frame& frame, FrameType type, std::vector<EncodedFrame>& output) {
+    auto start = chrono::steady_clock::now();
+    output.push_back(encodePicture(frame, type));
+    if(settings.realTime) {
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if(speedController.update(seconds)) {
+            applySpeedLevel();
+        }
+    }
+}
+
+/**
+ * Switch to the settings of the current speed level, from the next frame on
+ */
+void VideoEncoder::applySpeedLevel() {
+    settings = speedController.settings();
+    for(auto search : {&estimator, &backwardEstimator}) {
+        search->searchRange = settings.searchRange;
+        search->subpelRefinement = settings.subpelRefinement;
+    }
+    rateController.setQuantizers(settings.quantizer, settings.minQuantizer);
+}
+
+void VideoEncoder::allocate(int width, int height) {
+    inputs = make_unique<Pool<Frame>>([width, height]() {
+        return make_unique<Frame>(width, height);
+    });
+    references = make_unique<Pool<InterpolatedFrame>>([width, height]() {
+        return make_unique<InterpolatedFrame>(width, height);
+    });
+    reconstructedB = Frame{width, height};
+}
+
+std::vector<EncodedFrame> VideoEncoder::push(const Frame& frame) {
+    if(not inputs) {
+        allocate(frame.width(), frame.height());
+    }
+
+    // copy into a recycled frame, the caller may reuse its own
+    auto queued = inputs->acquire();
+    *queued = frame;
+    queued->frameNumber = nextFrameNumber++;
+    lookahead.push_back(move(queued));
+
+    if(settings.sceneCutThreshold >= 0 && sceneDetector.isSceneChange(frame)) {
+        sceneCuts.insert(lookahead.back()->frameNumber);
+    }
+
+    // the queue holds at most lookahead frames, enough for a full group
+    auto depth = static_cast<size_t>(max(settings.lookahead, settings.bFrames + 1));
+    vector<EncodedFrame> output;
+    while(lookahead.size() >= depth) {
+        encodeGroup(output);
+    }
+    return output;
+}
+
+std::vector<EncodedFrame> VideoEncoder::flush() {
+    vector<EncodedFrame> output;
+    while(not lookahead.empty()) {
+        encodeGroup(output);
+    }
+    return output;
+}
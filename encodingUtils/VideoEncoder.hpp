@@ -0,0 +1,126 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+
+#include "EncodedFrame.hpp"
+#include "EncoderSettings.hpp"
+#include "Frame.hpp"
+#include "Interpolation.hpp"
+#include "MotionEstimator.hpp"
+#include "Pool.hpp"
+#include "RateController.hpp"
+#include "SceneDetector.hpp"
+#include "SpeedController.hpp"
+#include "ThreadPool.hpp"
+
+/**
+ * Encodes a sequence of frames. Every group of pictures starts with an I frame, the following frames are P frames
+ * predicted from the reconstruction of the I or P frame before them. Scene cuts detected when frames are pushed
+ * start a new group. With B frames enabled, up to bFrames frames between two I or P frames are coded as B frames
+ * after the later one.
+ *
+ * Frames are pushed in display order and come out in decode order, each tagged with its display frame number.
+ * Queued frames and references are recycled, after the first groups no frame buffers are allocated.
+ */
+class VideoEncoder {
+public:
+    /**
+     * Code the block rows on settings.threads threads of the encoder's own
+     */
+    explicit VideoEncoder(const EncoderSettings& settings = EncoderSettings{}): VideoEncoder{settings, nullptr} {
+        if(settings.threads > 1) {
+            ownedPool = std::make_unique<ThreadPool>(settings.threads);
+            pool = ownedPool.get();
+        }
+    };
+
+    /**
+     * Code the block rows on a scheduler shared with other stages, settings.threads is ignored
+     * @param pool The scheduler, nullptr codes the rows on the calling thread
+     */
+    VideoEncoder(const EncoderSettings& settings, ThreadPool* pool):
+            settings{settings},
+            estimator{settings.searchRange, settings.searchStrategy, settings.earlyTermination,
+                      settings.subpelRefinement},
+            backwardEstimator{settings.searchRange, settings.searchStrategy, settings.earlyTermination,
+                              settings.subpelRefinement},
+            sceneDetector{settings.sceneCutThreshold},
+            rateController{settings},
+            speedController{settings},
+            pool{pool} {};
+
+    /**
+     * Add the next frame of the sequence to the lookahead queue
+     * @param frame The frame, width and height must be multiples of 8 and the same for every frame
+     * @return The frames encoded because the queue was full, in decode order
+     */
+    std::vector<EncodedFrame> push(const Frame& frame);
+
+    /**
+     * Encode every frame left in the lookahead queue, at the end of the sequence
+     * @return The encoded frames in decode order
+     */
+    std::vector<EncodedFrame> flush();
+
+    /**
+     * @return The speed level of real time mode, 0 is the configured settings
+     */
+    int speedLevel() const {
+        return speedController.level();
+    }
+
+    /**
+     * @return The number of frames that took longer than the frame interval to encode, in real time mode
+     */
+    long long deadlineMisses() const {
+        return speedController.deadlineMisses();
+    }
+
+private:
+    class BlockVectors;
+    class RowProgress;
+
+    /**
+     * Encode the next group from the lookahead queue: an I or P frame and the B frames before it in display order
+     */
+    void encodeGroup(std::vector<EncodedFrame>& output);
+    bool isKeyframe(int frameNumber) const;
+    void allocate(int width, int height);
+
+    EncodedFrame encodePicture(const Frame& frame, FrameType type);
+    void encodeTimed(const Frame& frame, FrameType type, std::vector<EncodedFrame>& output);
+    void applySpeedLevel();
+    void encodeRow(const Frame& frame, Frame& reconstructed, int blockRow, BlockVectors& vectors,
+                   RowProgress* progress, EncodedFrame& output);
+    void encodeInterBlock(const Frame& frame, Frame& reconstructed, int top, int left, BlockVectors& vectors,
+                          std::vector<MotionVector>& predictors, EncodedFrame& output);
+    bool isStatic(const Frame& frame, const InterpolatedFrame& referenceFrame, int top, int left,
+                  int quantizer) const;
+    void encodeBlock(const Plane& source, Plane& reconstructed, BlockType type, int top, int left,
+                     const Matrix<int, Dynamic, Dynamic>& prediction, EncodedFrame& output) const;
+
+    EncoderSettings settings;
+    MotionEstimator estimator;
+    MotionEstimator backwardEstimator;
+    SceneDetector sceneDetector;
+    RateController rateController;
+    SpeedController speedController;
+    std::unique_ptr<ThreadPool> ownedPool;
+    ThreadPool* pool;               // the wavefront threads, nullptr with a single thread
+
+    // recycled copies of the pushed frames and reconstructions, created for the size of the first frame
+    std::unique_ptr<Pool<Frame>> inputs;
+    std::unique_ptr<Pool<InterpolatedFrame>> references;
+    Frame reconstructedB;           // reconstruction of the B frame being encoded, which is never referenced
+
+    std::deque<std::shared_ptr<Frame>> lookahead;   // frames pushed but not encoded yet, in display order
+    int nextFrameNumber = 0;
+    int lastKeyframe = -1;
+    std::set<int> sceneCuts;        // frame numbers of the detected cuts that are not encoded yet
+    std::vector<MotionVector> previousVectors;  // forward vectors of the last P frame, the temporal predictors
+
+    // reconstructions of the last two I or P frames, as the decoder will see them
+    std::shared_ptr<const InterpolatedFrame> previousAnchor;
+    std::shared_ptr<const InterpolatedFrame> lastAnchor;
+};
@@ -0,0 +1,35 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include "VideoStream.hpp"
+
+using namespace std;
+
+void VideoStream::append(EncodedFrame frame) {
+    if(frame.type == I_FRAME) {
+        keyframes.push_back(static_cast<int>(frames.size()));
+    }
+    frames.push_back(move(frame));
+}
+
+int VideoStream::keyframeBefore(int position) const {
+    // first keyframe after the position, the one before it is the answer
+    auto next = upper_bound(keyframes.begin(), keyframes.end(), position);
+    if(position >= static_cast<int>(frames.size()) || next == keyframes.begin()) {
+        throw out_of_range("no keyframe at or before position " + to_string(position));
+    }
+    return *(next - 1);
+}
+
+int VideoStream::positionOf(int frameNumber) const {
+    // frames are stored in decode order, which is close to display order
+    if(frameNumber >= 0 && frameNumber < static_cast<int>(frames.size()) && frames[frameNumber].frameNumber == frameNumber) {
+        return frameNumber;
+    }
+    for(size_t i=0; i<frames.size(); i++) {
+        if(frames[i].frameNumber == frameNumber) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
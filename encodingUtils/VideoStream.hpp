@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+
+#include "EncodedFrame.hpp"
+
+/**
+ * The encoded frames of a sequence in decode order, with an index of the keyframes
+ */
+class VideoStream {
+public:
+    std::vector<EncodedFrame> frames;
+    std::vector<int> keyframes;     // positions of the I frames in frames, ascending
+
+    /**
+     * Append the next encoded frame, recording it in the keyframe index if it is an I frame
+     */
+    void append(EncodedFrame frame);
+
+    /**
+     * @return The position of the last keyframe at or before the given position
+     * @throw out_of_range if the position is past the last frame or before the first keyframe
+     */
+    int keyframeBefore(int position) const;
+
+    /**
+     * @return The position in frames of the frame with the given display frame number, -1 if there is none
+     */
+    int positionOf(int frameNumber) const;
+};
@@ -2,8 +2,13 @@
 #include <chrono>
 #include <fstream>
 #include <algorithm>
+#include <thread>
 #include "ImageUtils/Image.hpp"
 #include "encodingUtils/Block.hpp"
+#include "encodingUtils/SegmentedStream.hpp"
+#include "encodingUtils/CoefficientDump.hpp"
+#include "encodingUtils/FramePipeline.hpp"
+#include "encodingUtils/ThreadPool.hpp"
 
 using namespace std;
 
@@ -41,27 +46,6 @@ void writeImageSample(Image& img, const string& filename) {
     stream.close();
 }
 
-tuple<vector<Block>, vector<Block>, vector<Block>> directTransformAll(tuple<vector<Block>, vector<Block>, vector<Block>> input) {
-    // put all blocks into a single vector
-    auto Y = get<0>(input);
-    auto U = get<1>(input);
-    auto V = get<2>(input);
-
-    // apply a forwardDCT to all elements of a list and return the list
-    auto transformOperation = [&](const vector<Block>& blocks) {
-        vector<Block> transformed;  // vector to write the transformed blocks into
-
-        // map the list of blocks to their transformed value
-        for(auto& block: blocks) {
-            transformed.push_back(block.forwardDCT());
-        }
-
-        return transformed;
-    };
-
-    return make_tuple(transformOperation(Y), transformOperation(U), transformOperation(V));
-}
-
 tuple<vector<Block>, vector<Block>, vector<Block>> inverseTransformAll(tuple<vector<Block>, vector<Block>, vector<Block>> input) {
     // put all blocks into a single vector
     auto Y = get<0>(input);
@@ -83,87 +67,64 @@ tuple<vector<Block>, vector<Block>, vector<Block>> inverseTransformAll(tuple<vec
     return make_tuple(transformOperation(Y), transformOperation(U), transformOperation(V));
 }
 
-int main() {
+int main(int argc, char** argv) {
     auto t1 = std::chrono::high_resolution_clock::now();
 
-    auto img = Image{"../image.ppm"};
-    //auto converted = img.getYCbCrImage();
-    writeImageSample(img, "../blocksOut/original.txt");
-
-    // create a list of 8x8 matrixes containing the 64 values, the type of block (Y) and the position of the block in
-    // the original image
-    tuple<vector<Block>, vector<Block>, vector<Block>> encoded = img.encode();
-
-
-
-//    auto directTransformed = directTransformAll(encoded);
-//    auto inverseTransformed = inverseTransformAll(directTransformed);
-//    writeBlockToFile("../blocksOut/beforeDCT", get<0>(encoded)[0]);
-//    writeBlockToFile("../blocksOut/afterDCT", get<0>(directTransformed)[0]);
-//    writeBlockToFile("../blocksOut/afterIDCT", get<0>(inverseTransformed)[0]);
-
-    vector<ACCoefficient> entropy_encoded;
-
-    int noOfBlocks = get<0>(encoded).size();
-
-    // place all ACCoefficients in the output
-    for(size_t i=0; i<noOfBlocks; i++) {
-        // get the i-th block of each type
-        // skip the DCT part, expand to 8x8
-
-        auto y = get<0>(encoded)[i].expandTo8x8();
-        auto cb = get<1>(encoded)[i].expandTo8x8();
-        auto cr = get<2>(encoded)[i].expandTo8x8();
-
+    // the threads of every parallel stage, started once
+    ThreadPool pool{max(1U, thread::hardware_concurrency())};
 
-        // encode them
-        auto encodedY = y->entropy_encode();
-        auto encodedCb = cb->entropy_encode();
-        auto encodedCr = cr->entropy_encode();
+    // --dump-coefficients records the input of the entropy stage for the entropy benchmark
+    vector<string> inputs(argv + 1, argv + argc);
+    auto dumpFlag = find(inputs.begin(), inputs.end(), "--dump-coefficients");
+    bool dumpCoefficients = dumpFlag != inputs.end();
+    if(dumpCoefficients) {
+        inputs.erase(dumpFlag);
+    }
 
-        for(const auto& e : encodedY) {
-            entropy_encoded.push_back(e);
+    if(not inputs.empty()) {
+        // encode the images given on the command line as a sequence, every stage on its own threads
+        ofstream output("../sequence.coded", ios::binary);
+        FramePipeline pipeline{RUN_LENGTH, 2, 2, 1, &pool};
+        size_t frames;
+        try {
+            frames = pipeline.run(inputs, output);
         }
-
-        for(const auto& e : encodedCb) {
-            entropy_encoded.push_back(e);
+        catch(const exception& e) {
+            cerr << "error: " << e.what() << endl;
+            return 1;
         }
 
-        for(const auto& e : encodedCr) {
-            entropy_encoded.push_back(e);
+        auto t2 = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>( t2 - t1 ).count();
+        std::cout << frames << " frames in " << duration << "ms" << endl;
+        const char* names[FramePipeline::STAGE_COUNT] = {"read", "convert", "transform", "entropy", "write"};
+        for(int stage=0; stage<FramePipeline::STAGE_COUNT; stage++) {
+            std::cout << names[stage] << ": " << pipeline.busySeconds(static_cast<PipelineStage>(stage)) * 1000 << "ms" << endl;
         }
+        return 0;
     }
 
-    vector<Block*> tmpY;
-    tmpY.reserve(7500);
-
-    vector<Block*> tmpU;
-    tmpU.reserve(7500);
+    auto img = Image{"../image.ppm"};
+    //auto converted = img.getYCbCrImage();
+    writeImageSample(img, "../blocksOut/original.txt");
 
-    vector<Block*> tmpV;
-    tmpV.reserve(7500);
+    // create a list of 8x8 matrixes containing the 64 values, the type of block (Y) and the position of the block in
+    // the original image
+    tuple<vector<Block>, vector<Block>, vector<Block>> encoded = img.encode(pool);
 
-    int i=0;
-    while(i < (int)entropy_encoded.size()) {
 
-        // read up to the point where the current block is full
-        auto yBlock = Block::entropy_decode(entropy_encoded, i);
-        yBlock->setType(Y);
 
-        auto cbBlock = Block::entropy_decode(entropy_encoded, i);
-        cbBlock->setType(U);
+    if(dumpCoefficients) {
+        // record the input of the entropy stage for the entropy benchmark
+        CoefficientDump::record(encoded, img.getWidth() / 8).write("../blocksOut/coefficients.dump");
+    }
 
-        auto crBlock = Block::entropy_decode(entropy_encoded, i);
-        crBlock->setType(V);
+    // entropy-encode the blocks into independently decodable segments of RESTART_INTERVAL block rows
+    const int RESTART_INTERVAL = 4;
+    auto entropy_encoded = SegmentedStream::encode(encoded, img.getWidth() / 8, RESTART_INTERVAL, pool);
 
-        // got the 3 types of blocks for the current image patch
-        tmpY.push_back(yBlock);
-        tmpU.push_back(cbBlock);
-        tmpV.push_back(crBlock);
-    }
-    // decode the array of ACCoefficients into blocks
-    // blocks are then fed into entropy-decoder
-    auto decoded_output = make_tuple(tmpY, tmpU, tmpV);
+    // decode the segments into blocks, one segment per thread at a time
+    auto decoded_output = entropy_encoded.decode(pool);
 
     //auto dequantized = inverseTransformAll(decoded_output);
 
@@ -194,7 +155,8 @@ int main() {
     }
 
     //Image decoded = Image::decode(adjustedInverse);
-    Image decoded = Image::decode(adjustedInverse, 600, 800);
+    // reconstruct the block rows in parallel, straight to RGB
+    Image decoded = Image::decode(adjustedInverse, 600, 800, pool);
     writeImageSample(decoded, "../blocksOut/decoded.txt");
 
     auto t2 = std::chrono::high_resolution_clock::now();